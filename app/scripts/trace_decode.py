@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Decode a `trace dump` capture from the mouse console.
+
+Usage: trace_decode.py capture.txt   (or pipe the console output in)
+
+Prints one line per record with the time since the first record in
+microseconds, the event and its arguments. Keep EVENTS in step with
+trace_event_t in src/trace.h.
+"""
+import struct
+import sys
+
+RECORD = struct.Struct("<IIBBhhh")
+
+EVENTS = {
+    1: ("usb_report", "buttons=0x{a8:02x} x={x} y={y} wheel={z}"),
+    2: ("ble_notify", "buttons=0x{a8:02x} x={x} y={y} wheel={z}"),
+    3: ("ble_notify_boot", "buttons=0x{a8:02x} x={x} y={y} wheel={z}"),
+    4: ("esb_report", "buttons=0x{a8:02x} x={x} y={y} wheel={z}"),
+    5: ("tx_error", "transport={a8} err={x}"),
+}
+
+
+def records(lines):
+    freq = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("TRACE "):
+            version, freq, _count = (int(v) for v in line.split()[1:4])
+            if version != 1:
+                sys.exit(f"unsupported trace format {version}")
+            continue
+        if line == "END" or freq is None:
+            continue
+        try:
+            raw = bytes.fromhex(line)
+        except ValueError:
+            continue  # log output mixed into the capture
+        if len(raw) == RECORD.size:
+            yield freq, RECORD.unpack(raw)
+
+
+def main():
+    src = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    t = None
+    last_cycles = None
+    for freq, (seq, cycles, event, a8, x, y, z) in records(src):
+        # The cycle counter is 32 bits, unwrap it between records
+        if last_cycles is None:
+            t = 0
+        else:
+            t += (cycles - last_cycles) & 0xFFFFFFFF
+        last_cycles = cycles
+        name, fmt = EVENTS.get(event, (f"event{event}", "a8={a8} x={x} y={y} z={z}"))
+        print(f"{t * 1e6 / freq:12.1f} us  #{seq:<8} {name:<16} " + fmt.format(a8=a8, x=x, y=y, z=z))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,15 +1,70 @@
 // src/battery.c
+#include <stdlib.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/fuel_gauge.h>
 #include <zephyr/logging/log.h>
+#if defined(CONFIG_BT_BAS)
+#include <zephyr/bluetooth/services/bas.h>
+#endif
 #include "battery.h"
 
 LOG_MODULE_REGISTER(battery, CONFIG_LOG_DEFAULT_LEVEL);
 
 static const struct device *battery_dev;
 
+// The gauge is only read from this work item; everyone else gets the cache
+static void battery_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(battery_work, battery_work_handler);
+
+static atomic_t battery_level = ATOMIC_INIT(-1);
+static int reported_level = -1;
+
+static int battery_read(int *percentage)
+{
+	fuel_gauge_prop_t prop = FUEL_GAUGE_RELATIVE_STATE_OF_CHARGE;
+	union fuel_gauge_prop_val val;
+
+	int ret = fuel_gauge_get_props(battery_dev, &prop, &val, 1);
+	if (ret < 0) {
+		return ret;
+	}
+
+	// The gauge can read slightly above 100 % right after charging
+	*percentage = MIN(val.relative_state_of_charge, 100);
+	return 0;
+}
+
+static void battery_report(int level)
+{
+	if (reported_level >= 0 &&
+	    abs(level - reported_level) < CONFIG_MOUSE_BATTERY_REPORT_THRESHOLD) {
+		return;
+	}
+	reported_level = level;
+
+	LOG_INF("Battery %d %%", level);
+#if defined(CONFIG_BT_BAS)
+	bt_bas_set_battery_level(level);
+#endif
+}
+
+static void battery_work_handler(struct k_work *work)
+{
+	int level;
+	int ret = battery_read(&level);
+
+	if (ret < 0) {
+		LOG_ERR("Failed to read battery level: %d", ret);
+	} else {
+		atomic_set(&battery_level, level);
+		battery_report(level);
+	}
+
+	k_work_schedule(&battery_work, K_SECONDS(CONFIG_MOUSE_BATTERY_SAMPLE_INTERVAL_S));
+}
+
 int battery_init(void)
 {
 	battery_dev = DEVICE_DT_GET(DT_ALIAS(fuel_gauge0));
@@ -20,24 +75,18 @@ int battery_init(void)
 	}
 
 	LOG_INF("Fuel gauge ready: %s", battery_dev->name);
+	k_work_schedule(&battery_work, K_NO_WAIT);
 	return 0;
 }
 
 int battery_get_percentage(int *percentage)
 {
-	if (battery_dev == NULL || !device_is_ready(battery_dev)) {
-		return -ENODEV;
-	}
-
-	fuel_gauge_prop_t prop = FUEL_GAUGE_RELATIVE_STATE_OF_CHARGE;
-	union fuel_gauge_prop_val val;
+	int level = atomic_get(&battery_level);
 
-	int ret = fuel_gauge_get_props(battery_dev, &prop, &val, 1);
-	if (ret < 0) {
-		LOG_ERR("Failed to read battery voltage: %d", ret);
-		return ret;
+	if (level < 0) {
+		return battery_dev == NULL || !device_is_ready(battery_dev) ? -ENODEV : -EAGAIN;
 	}
 
-	*percentage = val.relative_state_of_charge;
+	*percentage = level;
 	return 0;
 }
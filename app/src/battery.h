@@ -3,6 +3,9 @@
 #define BATTERY_H
 
 int battery_init(void);
+
+// Last level sampled in the background, no bus access. -EAGAIN until the
+// first sample is in.
 int battery_get_percentage(int *percentage);
 
 #endif // BATTERY_H
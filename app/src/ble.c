@@ -20,6 +20,11 @@
 #include <zephyr/bluetooth/gatt.h>
 
 #include "ble_hids.h"
+#include "motion_sync.h"
+
+#if defined(CONFIG_MOUSE_BLE_CONN_SYNC)
+#include <bluetooth/radio_notification_cb.h>
+#endif
 
 #define DEVICE_NAME CONFIG_BT_DEVICE_NAME
 #define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
@@ -159,6 +164,7 @@ static void s_connected(struct bt_conn *conn, uint8_t err)
 
     /* Inform HID Service */
     ble_hids_connected(conn);
+    transport_link_changed(TRANSPORT_BLE, true);
 }
 
 static void s_disconnected(struct bt_conn *conn, uint8_t reason)
@@ -170,6 +176,7 @@ static void s_disconnected(struct bt_conn *conn, uint8_t reason)
     printk("Disconnected from %s (reason %u)\n", addr, reason);
 
     /* Inform HID Service */
+    transport_link_changed(TRANSPORT_BLE, false);
     ble_hids_disconnected();
 
     is_connected = false;
@@ -231,36 +238,70 @@ static struct bt_conn_auth_info_cb conn_auth_info_callbacks = {
     .pairing_complete = s_pairing_complete,
     .pairing_failed = s_pairing_failed};
 
-void ble_init(void)
+#if defined(CONFIG_MOUSE_BLE_CONN_SYNC)
+/* Called by the controller a fixed time before every connection event */
+static void s_conn_prepare(struct bt_conn *conn)
 {
-    int err;
+    ARG_UNUSED(conn);
+    motion_sync_conn_event();
+}
 
-    printk("Starting ble application\n");
+static const struct bt_radio_notification_conn_cb radio_notification_conn_callbacks = {
+    .prepare = s_conn_prepare};
+#endif
 
-    err = bt_conn_auth_info_cb_register(&conn_auth_info_callbacks);
+/* Rest of the bring-up once the controller is up, in the system workqueue */
+static void s_bt_ready(int err)
+{
     if (err)
     {
-        printk("Failed to register authorization info callbacks.\n");
+        printk("Bluetooth init failed (err %d)\n", err);
         return;
     }
 
-    err = bt_enable(NULL);
+    printk("Bluetooth initialized\n");
+
+#if defined(CONFIG_MOUSE_BLE_CONN_SYNC)
+    /* Pace mouse notifications to the connection events */
+    err = bt_radio_notification_conn_cb_register(&radio_notification_conn_callbacks,
+                                                 CONFIG_MOUSE_BLE_CONN_SYNC_PREPARE_US);
     if (err)
     {
-        printk("Bluetooth init failed (err %d)\n", err);
-        return;
+        printk("Failed to register connection event callback (err %d)\n", err);
     }
-
-    printk("Bluetooth initialized\n");
+#endif
 
     if (IS_ENABLED(CONFIG_SETTINGS))
     {
         settings_load();
     }
 
+    /* Immediately request advertising to start */
+    s_advertising_start();
+}
+
+void ble_init(void)
+{
+    int err;
+
+    printk("Starting ble application\n");
+
+    transport_register(TRANSPORT_BLE, &ble_hids_transport);
+
+    err = bt_conn_auth_info_cb_register(&conn_auth_info_callbacks);
+    if (err)
+    {
+        printk("Failed to register authorization info callbacks.\n");
+        return;
+    }
+
     /* Init workqueue item to help during advertising */
     k_work_init(&adv_work, s_advertising_process);
 
-    /* Immediately request advertising to start */
-    s_advertising_start();
+    /* Returns right away, the controller comes up while the rest of the mouse initializes */
+    err = bt_enable(s_bt_ready);
+    if (err)
+    {
+        printk("Bluetooth init failed (err %d)\n", err);
+    }
 }
@@ -13,6 +13,9 @@
 #include <zephyr/bluetooth/gatt.h>
 
 #include "ble_hids.h"
+#include "latency.h"
+#include "trace.h"
+#include "boot_timing.h"
 
 #define REPORT_MOUSE_SIZE sizeof(ble_hids_report_mouse_t)
 #define BOOT_REPORT_MOUSE_SIZE sizeof(ble_hids_report_mouse_boot_t)
@@ -345,26 +348,32 @@ ble_hids_prot_mode_t ble_hids_get_prot_mode(void)
 
 bool ble_hids_is_mouse_report_writable(void)
 {
+    /* Polled by the report path as the transport's is_ready(), keep it quiet */
+
     /* Return false if connection is still not encrypted */
     if ((active_conn == NULL) || (bt_conn_get_security(active_conn) < BT_SECURITY_L2))
     {
-        printk("Connection is not encrypted, mouse report is not writable\n");
         return false;
     }
 
     if (prot_mode == BLE_HIDS_PM_BOOT)
     {
-        printk("Boot Protocol Mode PM BOOT is active, mouse report is writable\n");
         return mse_boot_input_rep_notif_enabled;
     }
     else
     {
-        printk("Report Protocol Mode is active, mouse report is writable, ccc is %d\n", mse_input_rep_notif_enabled);
         return mse_input_rep_notif_enabled;
     }
 }
 
-void ble_hids_mouse_notify_input(const void *data, uint8_t dataLen)
+/* The controller has sent the notification */
+static void s_notify_sent(struct bt_conn *conn, void *user_data)
+{
+    ARG_UNUSED(conn);
+    latency_tx_done(user_data);
+}
+
+int ble_hids_mouse_notify_input(const void *data, uint8_t dataLen, void *latency_token)
 {
     __ASSERT_NO_MSG(dataLen == sizeof(mse_input_report));
     __ASSERT_NO_MSG(mse_input_rep_notif_enabled);
@@ -378,19 +387,20 @@ void ble_hids_mouse_notify_input(const void *data, uint8_t dataLen)
     params.uuid = BT_UUID_HIDS_REPORT;
     params.data = data;
     params.len = dataLen;
-    params.func = NULL;
-
-    printk("Sending mouse notification: buttons %02x, move_x %d, move_y %d, scroll_v %d\n",
-           ((ble_hids_report_mouse_t *)data)->buttons_bitmask,
-           ((ble_hids_report_mouse_t *)data)->move_x_lsb |
-               (((ble_hids_report_mouse_t *)data)->move_x_msb << 8),
-           ((ble_hids_report_mouse_t *)data)->move_y_lsb |
-               (((ble_hids_report_mouse_t *)data)->move_y_msb << 8),
-           ((ble_hids_report_mouse_t *)data)->scroll_v);
+    params.func = s_notify_sent;
+    params.user_data = latency_token;
+
+    TRACE(TRACE_EV_BLE_NOTIFY, ((ble_hids_report_mouse_t *)data)->buttons_bitmask,
+          ((ble_hids_report_mouse_t *)data)->move_x_lsb |
+              (((ble_hids_report_mouse_t *)data)->move_x_msb << 8),
+          ((ble_hids_report_mouse_t *)data)->move_y_lsb |
+              (((ble_hids_report_mouse_t *)data)->move_y_msb << 8),
+          ((ble_hids_report_mouse_t *)data)->scroll_v);
     err = bt_gatt_notify_cb(active_conn, &params);
+    return err;
 }
 
-void ble_hids_mouse_notify_boot(const void *data, uint8_t dataLen)
+int ble_hids_mouse_notify_boot(const void *data, uint8_t dataLen, void *latency_token)
 {
     __ASSERT_NO_MSG(dataLen == sizeof(mse_boot_input_report));
     __ASSERT_NO_MSG(mse_boot_input_rep_notif_enabled);
@@ -404,14 +414,15 @@ void ble_hids_mouse_notify_boot(const void *data, uint8_t dataLen)
     params.uuid = BT_UUID_HIDS_BOOT_MOUSE_IN_REPORT;
     params.data = data;
     params.len = dataLen;
-    params.func = NULL;
+    params.func = s_notify_sent;
+    params.user_data = latency_token;
 
-    printk("Sending boot mouse notification: buttons %02x, move_x %d, move_y %d, scroll_v %d\n",
-           ((ble_hids_report_mouse_boot_t *)data)->buttons_bitmask,
-           ((ble_hids_report_mouse_boot_t *)data)->move_x,
-           ((ble_hids_report_mouse_boot_t *)data)->move_y,
-           ((ble_hids_report_mouse_boot_t *)data)->scroll_v);
+    TRACE(TRACE_EV_BLE_NOTIFY_BOOT, ((ble_hids_report_mouse_boot_t *)data)->buttons_bitmask,
+          ((ble_hids_report_mouse_boot_t *)data)->move_x,
+          ((ble_hids_report_mouse_boot_t *)data)->move_y,
+          ((ble_hids_report_mouse_boot_t *)data)->scroll_v);
     err = bt_gatt_notify_cb(active_conn, &params);
+    return err;
 }
 
 static inline uint8_t mouse_buttons_mask(bool left, bool right, bool middle, bool back, bool forward)
@@ -442,44 +453,74 @@ static inline uint8_t mouse_buttons_mask(bool left, bool right, bool middle, boo
     return mask;
 }
 
-void ble_hids_send_mouse_notification(bool left, bool right, bool mid, bool forward, bool backward, int16_t move_x, int16_t move_y, int8_t scroll_v)
+/* Anything not handed to the stack is -EIO, so tx_thread owes its counts and buttons again */
+static int s_send_report(const mouse_report_t *report)
 {
     ble_hids_prot_mode_t currProtMode = ble_hids_get_prot_mode();
-    printk("currProtMode = %d\n", currProtMode);
+    int err = 0;
 
-    uint8_t buttons_bitmask = mouse_buttons_mask(left, right, mid, backward, forward);
+    if (!ble_hids_is_mouse_report_writable())
+    {
+        return -EIO;
+    }
+
+    if (BLE_HIDS_PM_REPORT == currProtMode)
+    {
+        ble_hids_report_mouse_t mse_report =
+            {
+                .buttons_bitmask = report->buttons,
+                .move_x_lsb = (uint8_t)report->x,
+                .move_x_msb = (uint8_t)(report->x >> 8) & 0xFF,
+                .move_y_lsb = (uint8_t)report->y,
+                .move_y_msb = (uint8_t)(report->y >> 8) & 0xFF,
+                .scroll_v = report->wheel};
+
+        err = ble_hids_mouse_notify_input(&mse_report, sizeof(ble_hids_report_mouse_t),
+                                          latency_tx_start(&report->latency));
+    }
+    else if (BLE_HIDS_PM_BOOT == currProtMode)
+    {
+        ble_hids_report_mouse_boot_t mse_boot_report =
+            {
+                .buttons_bitmask = report->buttons,
+                .move_x = CLAMP(report->x, INT8_MIN, INT8_MAX),
+                .move_y = CLAMP(report->y, INT8_MIN, INT8_MAX),
+                .scroll_v = report->wheel};
+
+        err = ble_hids_mouse_notify_boot(&mse_boot_report, sizeof(ble_hids_report_mouse_boot_t),
+                                         latency_tx_start(&report->latency));
+    }
 
-    if (ble_hids_is_mouse_report_writable())
+    /* -ENOMEM with the TX buffers full, -ENOTCONN racing a disconnect */
+    if (err)
     {
-        if (BLE_HIDS_PM_REPORT == currProtMode)
-        {
-            printk("Sending mouse report: buttons %02x, move_x %d, move_y %d, scroll_v %d\n",
-                   buttons_bitmask, move_x, move_y, scroll_v);
-            ble_hids_report_mouse_t mse_report =
-                {
-                    .buttons_bitmask = buttons_bitmask,
-                    .move_x_lsb = (uint8_t)move_x,
-                    .move_x_msb = (uint8_t)(move_x >> 8) & 0xFF,
-                    .move_y_lsb = (uint8_t)move_y,
-                    .move_y_msb = (uint8_t)(move_y >> 8) & 0xFF,
-                    .scroll_v = scroll_v};
-
-            ble_hids_mouse_notify_input(&mse_report, sizeof(ble_hids_report_mouse_t));
-        }
-        else if (BLE_HIDS_PM_BOOT == currProtMode)
-        {
-            printk("Sending boot mouse report: buttons %02x, move_x %d, move_y %d, scroll_v %d\n",
-                   buttons_bitmask, move_x, move_y, scroll_v);
-            ble_hids_report_mouse_boot_t mse_boot_report =
-                {
-                    .buttons_bitmask = buttons_bitmask,
-                    .move_x = move_x, /* implicit cast to 8 bits */
-                    .move_y = move_y, /* implicit cast to 8 bits */
-                    .scroll_v = scroll_v};
-
-            ble_hids_mouse_notify_boot(&mse_boot_report, sizeof(ble_hids_report_mouse_boot_t));
-        }
+        return -EIO;
     }
+    boot_timing_report_sent(TRANSPORT_BLE);
+    return 0;
+}
+
+static report_format_t s_max_report_format(void)
+{
+    return (ble_hids_get_prot_mode() == BLE_HIDS_PM_REPORT) ? REPORT_FORMAT_16BIT : REPORT_FORMAT_8BIT;
+}
+
+const transport_t ble_hids_transport = {
+    .name = "ble",
+    .send_report = s_send_report,
+    .is_ready = ble_hids_is_mouse_report_writable,
+    .max_report_format = s_max_report_format,
+};
+
+void ble_hids_send_mouse_notification(bool left, bool right, bool mid, bool forward, bool backward, int16_t move_x, int16_t move_y, int8_t scroll_v)
+{
+    mouse_report_t report = {
+        .x = move_x,
+        .y = move_y,
+        .wheel = scroll_v,
+        .buttons = mouse_buttons_mask(left, right, mid, backward, forward)};
+
+    s_send_report(&report);
 }
 
 #define STEP_SIZE 10  // pixels per step
@@ -9,6 +9,7 @@ extern "C"
 #include <zephyr/bluetooth/conn.h>
 
 #include "ble_hids_def.h"
+#include "transport.h"
 
     void ble_hids_connected(struct bt_conn *conn);
     void ble_hids_disconnected(void);
@@ -16,12 +17,16 @@ extern "C"
     ble_hids_prot_mode_t ble_hids_get_prot_mode(void);
 
     bool ble_hids_is_mouse_report_writable(void);
-    void ble_hids_mouse_notify_input(const void *data, uint8_t dataLen);
-    void ble_hids_mouse_notify_boot(const void *data, uint8_t dataLen);
+    /* latency_token from latency_tx_start(), may be NULL */
+    int ble_hids_mouse_notify_input(const void *data, uint8_t dataLen, void *latency_token);
+    int ble_hids_mouse_notify_boot(const void *data, uint8_t dataLen, void *latency_token);
     void ble_hids_send_mouse_notification(bool left, bool right, bool mid, bool forward, bool backward, int16_t move_x, int16_t move_y, int8_t scroll_v);
 
     void ble_hids_test_mouse_square(void);
 
+    /* Mouse reports over HIDS, registered as TRANSPORT_BLE */
+    extern const transport_t ble_hids_transport;
+
 #ifdef __cplusplus
 }
 #endif
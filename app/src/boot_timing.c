@@ -0,0 +1,93 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "boot_timing.h"
+
+LOG_MODULE_REGISTER(boot_timing, LOG_LEVEL_INF);
+
+#if defined(CONFIG_MOUSE_BOOT_TIMING)
+
+static const char *const link_names[TRANSPORT_COUNT] = {
+    [TRANSPORT_USB] = "usb",
+    [TRANSPORT_ESB] = "esb",
+    [TRANSPORT_BLE] = "ble",
+};
+
+// Uptime in ms, 0 until it happened
+static atomic_t init_done_ms;
+static atomic_t link_ready_ms[TRANSPORT_COUNT];
+static atomic_t first_report_ms[TRANSPORT_COUNT];
+
+// First call wins. Returns the time recorded, 0 if it was already set.
+static uint32_t mark_once(atomic_t *mark)
+{
+    uint32_t now = k_uptime_get_32();
+
+    now = MAX(now, 1);
+
+    return atomic_cas(mark, 0, now) ? now : 0;
+}
+
+void boot_timing_init_done(void)
+{
+    uint32_t ms = mark_once(&init_done_ms);
+
+    if (ms)
+    {
+        LOG_INF("boot: init done at %u ms", ms);
+    }
+}
+
+void boot_timing_link_ready(transport_id_t id)
+{
+    uint32_t ms = mark_once(&link_ready_ms[id]);
+
+    if (ms)
+    {
+        LOG_INF("boot: %s ready for reports at %u ms", link_names[id], ms);
+    }
+}
+
+void boot_timing_report_sent(transport_id_t id)
+{
+    uint32_t ms = mark_once(&first_report_ms[id]);
+
+    if (ms)
+    {
+        LOG_INF("boot: first %s report at %u ms", link_names[id], ms);
+    }
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_boot(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "init done    %u ms", (uint32_t)atomic_get(&init_done_ms));
+    for (int i = 0; i < TRANSPORT_COUNT; i++)
+    {
+        shell_print(sh, "%-4s ready %u ms, first report %u ms (0: not yet)", link_names[i],
+                    (uint32_t)atomic_get(&link_ready_ms[i]), (uint32_t)atomic_get(&first_report_ms[i]));
+    }
+    return 0;
+}
+
+SHELL_CMD_REGISTER(boot, NULL, "Time from reset to each link being usable", cmd_boot);
+#endif
+
+#else
+void boot_timing_init_done(void)
+{
+}
+
+void boot_timing_link_ready(transport_id_t id)
+{
+    ARG_UNUSED(id);
+}
+
+void boot_timing_report_sent(transport_id_t id)
+{
+    ARG_UNUSED(id);
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include "transport.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Milestones after reset, each recorded once and logged as it happens:
+    // init returned, a link can take reports, the first report went to it.
+    // Without CONFIG_MOUSE_BOOT_TIMING these do nothing.
+    void boot_timing_init_done(void);
+
+    // The active link's is_ready() passed, e.g. BLE once encrypted with
+    // notifications enabled
+    void boot_timing_link_ready(transport_id_t id);
+
+    // Called by the transport once the link has the report: USB when the
+    // IN transfer completed, BLE when the stack took the notification,
+    // ESB on the ACK
+    void boot_timing_report_sent(transport_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_TIMING_H
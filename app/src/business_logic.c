@@ -2,6 +2,9 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
+#if defined(CONFIG_PAW3395_ASYNC)
+#include <zephyr/rtio/rtio.h>
+#endif
 
 #include "business_logic.h"
 #include "encoder.h"
@@ -10,55 +13,241 @@
 #include "paw3395.h"
 #include "battery.h"
 #include "usb_hid.h"
+#if defined(CONFIG_BT)
 #include "ble.h"
-#include "ble_hids.h"
+#endif
+#if defined(CONFIG_MOUSE_ESB)
+#include "esb_transport.h"
+#endif
+#include "motion_accum.h"
+#include "motion_sync.h"
+#include "transport.h"
+#include "trace.h"
+#include "report_sched.h"
+#include "boot_timing.h"
 
 LOG_MODULE_REGISTER(business_logic, LOG_LEVEL_DBG);
 
 // polling rate options 1ms, 0.125ms
 #define POLLING_RATE_1000US 1000
 #define POLLING_RATE_125US 125
+
+// Input pipeline, highest priority first:
+//   sensor  - burst-reads the PAW3395 into motion_accum on the motion pin
+//   report  - paced by the link, or woken by input and link changes;
+//             coalesces motion, wheel and buttons into reports for
+//             report_msgq
+//   tx      - hands reports to the active transport, may block on it
+//   main    - polling_run(): link tracking, DPI button, LED
+// A stalled transport only fills report_msgq; motion keeps integrating in
+// motion_accum and goes out in the next report that fits. The sensor thread
+// is cooperative so it preempts everything else, the later stages are
+// preemptible and main runs below them (CONFIG_MAIN_THREAD_PRIORITY).
+#define SENSOR_THREAD_STACK_SIZE 1024
+#define SENSOR_THREAD_PRIORITY K_PRIO_COOP(2)
+#define REPORT_THREAD_STACK_SIZE 1024
+#define REPORT_THREAD_PRIORITY K_PRIO_PREEMPT(1)
+#define TX_THREAD_STACK_SIZE 2048
+#define TX_THREAD_PRIORITY K_PRIO_PREEMPT(2)
+#define REPORT_QUEUE_DEPTH 2
+#define HOUSEKEEPING_PERIOD_MS 10
+
 paw3395_cpi_enum_t cpi_val = PAW3395_CPI_1600;
 const struct device *paw3395 = DEVICE_DT_GET_ONE(pixart_paw3395);
 
-typedef enum
+K_THREAD_STACK_DEFINE(sensor_thread_stack, SENSOR_THREAD_STACK_SIZE);
+static struct k_thread sensor_thread;
+static K_SEM_DEFINE(motion_sem, 0, 1);
+// the sensor thread and a link sample point can both read
+static K_MUTEX_DEFINE(sensor_read_lock);
+
+K_THREAD_STACK_DEFINE(report_thread_stack, REPORT_THREAD_STACK_SIZE);
+static struct k_thread report_thread;
+// wakes the report stage when it is not paced by the link
+static K_SEM_DEFINE(report_sem, 0, 1);
+K_THREAD_STACK_DEFINE(tx_thread_stack, TX_THREAD_STACK_SIZE);
+static struct k_thread tx_thread;
+
+static const struct sensor_trigger motion_trigger = {
+    .type = SENSOR_TRIG_DATA_READY,
+    .chan = SENSOR_CHAN_ALL,
+};
+
+#if defined(CONFIG_PAW3395_ASYNC)
+// one burst in flight at a time, buffers come from the RTIO mempool
+SENSOR_DT_READ_IODEV(paw3395_iodev, DT_COMPAT_GET_ANY_STATUS_OKAY(pixart_paw3395),
+                     {SENSOR_CHAN_POS_DX, 0}, {SENSOR_CHAN_POS_DY, 0});
+RTIO_DEFINE_WITH_MEMPOOL(sensor_rtio, 2, 2, 2, 32, sizeof(void *));
+#endif
+
+// deltas collected by the sensor thread, drained by the report path
+static struct k_spinlock motion_lock;
+static motion_accum_t motion_accum;
+static uint32_t motion_sample_cycles; // when the newest pending delta was read
+static latency_stamps_t motion_latency; // the oldest pending delta
+static uint32_t last_irq_cycles;        // motion IRQ already accounted for
+// Set by the motion IRQ, cleared by a burst that found nothing: link-paced
+// reads skip the burst while the sensor is idle
+static atomic_t sensor_moving = ATOMIC_INIT(1);
+// decides which built reports go to the tx stage
+static report_sched_t report_sched;
+
+K_MSGQ_DEFINE(report_msgq, sizeof(mouse_report_t), REPORT_QUEUE_DEPTH, 4);
+
+// Sensor run mode per link: full tracking performance when powered over
+// USB, lower sensor current on battery links
+static const enum paw3395_run_mode link_run_mode[] = {
+    [TRANSPORT_USB] = GAME_MODE,
+    [TRANSPORT_ESB] = HP_MODE,
+    [TRANSPORT_BLE] = LP_MODE,
+    [TRANSPORT_NONE] = LP_MODE,
+};
+
+static void motion_trigger_handler(const struct device *dev, const struct sensor_trigger *trig)
 {
-    CONN_NONE,
-    CONN_USB,
-    CONN_ESB,
-    CONN_BLE
-} connection_type_enum_t;
+    // ISR context: only wake the acquisition thread
+    atomic_set(&sensor_moving, 1);
+    k_sem_give(&motion_sem);
+}
 
-static void sensor_cursor_init()
+#if defined(CONFIG_PAW3395_ASYNC)
+// Submit the burst through RTIO: the SPI runs from its own interrupt while
+// this thread sleeps, leaving the CPU to the report path.
+static int sensor_read_frame(struct paw3395_motion_frame *frame)
 {
-    if (!device_is_ready(paw3395))
+    struct rtio_cqe *cqe;
+    uint8_t *buf;
+    uint32_t buf_len;
+    int err;
+
+    err = sensor_read_async_mempool(&paw3395_iodev, &sensor_rtio, NULL);
+    if (err)
     {
-        LOG_ERR("PAW3395 device not ready");
+        return err;
+    }
+
+    cqe = rtio_cqe_consume_block(&sensor_rtio);
+    err = cqe->result;
+    if (err == 0)
+    {
+        err = rtio_cqe_get_mempool_buffer(&sensor_rtio, cqe, &buf, &buf_len);
+    }
+    rtio_cqe_release(&sensor_rtio, cqe);
+    if (err)
+    {
+        return err;
     }
+
+    err = paw3395_decode_motion(buf, frame);
+    rtio_release_buffer(&sensor_rtio, buf, buf_len);
+
+    return err;
+}
+#else
+static int sensor_read_frame(struct paw3395_motion_frame *frame)
+{
+    return paw3395_read_motion(paw3395, frame);
 }
+#endif
 
-static int get_connection_type()
+// Burst-read the sensor once and add the result to the pending deltas.
+// Returns true while the sensor still reports movement.
+static bool sensor_sample_motion(void)
 {
-    bool ble_connected = ble_is_connected();
-    bool usb_connected = usb_hid_mouse_is_connected();
-    bool esb_connected = false; // Placeholder for ESB connection check
+    struct paw3395_motion_frame frame;
 
-    // connection selection logic: USB > ESB > BLE
-    if (usb_connected)
+    k_mutex_lock(&sensor_read_lock, K_FOREVER);
+    int err = sensor_read_frame(&frame);
+    k_mutex_unlock(&sensor_read_lock);
+    if (err == -ENODATA || err == -EBUSY)
     {
-        return CONN_USB;
+        // Motion bit clear, or the sensor is still powering up
+        return false;
     }
-    else if (esb_connected)
+    if (err)
     {
-        return CONN_ESB;
+        LOG_ERR("Failed to fetch sensor data");
+        return false;
     }
-    else if (ble_connected)
+
+    if (frame.dx == 0 && frame.dy == 0)
     {
-        return CONN_BLE;
+        return false;
     }
-    else
+
+    // Only the first burst after an IRQ is timed from the IRQ, the ones
+    // polled after it from their own start
+    uint32_t now = k_cycle_get_32();
+    uint32_t origin = frame.timestamp;
+    if (frame.irq_timestamp != last_irq_cycles)
     {
-        return CONN_NONE; // No connection
+        origin = frame.irq_timestamp;
+        last_irq_cycles = frame.irq_timestamp;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&motion_lock);
+    if (motion_accum.x == 0 && motion_accum.y == 0)
+    {
+        motion_latency.origin = origin ? origin : 1;
+        motion_latency.read = now;
+    }
+    motion_accum_add(&motion_accum, frame.dx, frame.dy, 0);
+    motion_sample_cycles = frame.timestamp;
+    k_spin_unlock(&motion_lock, key);
+
+    return true;
+}
+
+static void sensor_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1)
+    {
+        // Sleep until the motion pin fires
+        k_sem_take(&motion_sem, K_FOREVER);
+
+        // The pin only edges once per motion episode, so keep reading at
+        // the polling rate until the sensor goes quiet again. With USB
+        // motion sync engaged the polling loop reads at the frame's sample
+        // point instead. On BLE this keeps integrating between connection
+        // events so the sensor's 16-bit counters can't overflow.
+        while (!motion_sync_engaged(MOTION_SYNC_USB) && sensor_sample_motion())
+        {
+            polling_wake();
+            k_usleep(UPDATE_RATE);
+        }
+    }
+}
+
+static void sensor_cursor_init()
+{
+    if (!device_is_ready(paw3395))
+    {
+        LOG_ERR("PAW3395 device not ready");
+        return;
+    }
+
+    k_thread_create(&sensor_thread, sensor_thread_stack,
+                    K_THREAD_STACK_SIZEOF(sensor_thread_stack),
+                    sensor_thread_fn, NULL, NULL, NULL,
+                    SENSOR_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&sensor_thread, "sensor");
+
+    int err = sensor_trigger_set(paw3395, &motion_trigger, motion_trigger_handler);
+    if (err)
+    {
+        LOG_ERR("Failed to set motion trigger: %d", err);
+        return;
+    }
+
+    // Drain anything latched before the interrupt was armed. If the sensor
+    // is still powering up, the driver calls the handler once it is done.
+    if (paw3395_is_ready(paw3395))
+    {
+        k_sem_give(&motion_sem);
     }
 }
 
@@ -76,33 +265,39 @@ static void rotate_dpi()
 
 static void update_led(paw3395_cpi_enum_t cpi_val)
 {
+    led_color_t color;
+
     switch (cpi_val)
     {
     case PAW3395_CPI_800:
-        led_set_color(LED_COLOR_RED);
+        color = LED_COLOR_RED;
         break;
     case PAW3395_CPI_1600:
-        led_set_color(LED_COLOR_GREEN);
+        color = LED_COLOR_GREEN;
         break;
     case PAW3395_CPI_2400:
-        led_set_color(LED_COLOR_YELLOW);
+        color = LED_COLOR_YELLOW;
         break;
     case PAW3395_CPI_3200:
-        led_set_color(LED_COLOR_ORANGE);
+        color = LED_COLOR_ORANGE;
         break;
     case PAW3395_CPI_5000:
-        led_set_color(LED_COLOR_PURPLE);
+        color = LED_COLOR_PURPLE;
         break;
     case PAW3395_CPI_10000:
-        led_set_color(LED_COLOR_CYAN);
+        color = LED_COLOR_CYAN;
         break;
     case PAW3395_CPI_26000:
-        led_set_color(LED_COLOR_BLUE);
+        color = LED_COLOR_BLUE;
         break;
     default:
-        led_set_color(LED_COLOR_OFF);
+        color = LED_COLOR_OFF;
         break;
     }
+
+    // Both only hand the change to the LED engine
+    led_set_color(color);
+    led_flash(color);
 }
 
 static int get_encoder_increment()
@@ -135,31 +330,30 @@ static bool get_switch_state_backward()
     return switch_get_state_backward();
 }
 
-static void send_output_to_host(
-    int cursor_x, int cursor_y,
-    int encoder_increment, bool encoder_button_state,
-    bool switch_right_state, bool switch_left_state, bool switch_forward_state, bool switch_backward_state)
+static void handle_link_change(transport_id_t connection_type)
 {
-    connection_type_enum_t connection_type = get_connection_type();
-    switch (connection_type)
+    static bool applied = false;
+    static transport_id_t applied_type;
+
+    if (applied && connection_type == applied_type)
     {
-    case CONN_USB:
-        // Send over USB
-        usb_hid_mouse_update(switch_right_state, switch_left_state, encoder_button_state, switch_forward_state, switch_backward_state, cursor_x, cursor_y, encoder_increment);
-        // usb_hid_mouse_test();
-        break;
-    case CONN_ESB:
-        // Send over ESB
-        break;
-    case CONN_BLE:
-        // Send over BLE
-        ble_hids_send_mouse_notification(switch_right_state, switch_left_state, encoder_button_state, switch_forward_state, switch_backward_state, cursor_x, cursor_y, encoder_increment);
-        // ble_hids_test_mouse_square();
-        break;
-    default:
-        // No connection
-        break;
+        return;
     }
+
+    struct sensor_value val = {.val1 = link_run_mode[connection_type]};
+    int err = sensor_attr_set(paw3395, SENSOR_CHAN_ALL, PAW3395_ATTR_RUN_MODE, &val);
+    if (err == -EBUSY)
+    {
+        // Sensor still powering up, try again on the next pass
+        return;
+    }
+    if (err)
+    {
+        LOG_ERR("Failed to set run mode %d: %d", val.val1, err);
+    }
+
+    applied = true;
+    applied_type = connection_type;
 }
 
 static void handle_dpi_button(bool dpi_button_state)
@@ -176,71 +370,254 @@ static void handle_dpi_button(bool dpi_button_state)
     prev_dpi_button_state = dpi_button_state;
 }
 
-static void get_cursor_position(int *x, int *y)
+// Cached level only, the fuel gauge is read in the background
+static void handle_battery_led(void)
 {
-    struct sensor_value dx, dy;
-    if (sensor_sample_fetch(paw3395) == 0)
+    int battery_percent;
+
+    if (battery_get_percentage(&battery_percent) == 0)
     {
-        sensor_channel_get(paw3395, SENSOR_CHAN_POS_DX, &dx);
-        sensor_channel_get(paw3395, SENSOR_CHAN_POS_DY, &dx);
+        led_set_battery_low(battery_percent <= CONFIG_MOUSE_BATTERY_LOW_PERCENT);
+    }
+}
 
-        // Update cursor position
-        *x = dx.val1;
-        *y = dy.val1;
+static void add_wheel_motion(int encoder_increment)
+{
+    k_spinlock_key_t key = k_spin_lock(&motion_lock);
+    motion_accum_add(&motion_accum, 0, 0, encoder_increment);
+    k_spin_unlock(&motion_lock, key);
+}
+
+// Take the largest chunk of pending motion the active report format can
+// carry; whatever does not fit stays for the next report
+static void get_report_motion(report_format_t format,
+                              int16_t *x, int16_t *y, int8_t *wheel, uint32_t *sample_cycles,
+                              latency_stamps_t *latency)
+{
+    k_spinlock_key_t key = k_spin_lock(&motion_lock);
+    motion_accum_take(&motion_accum, format, x, y, wheel);
+    *sample_cycles = motion_sample_cycles;
+    *latency = motion_latency;
+    k_spin_unlock(&motion_lock, key);
+}
+
+// The transport lost a report: owe its counts again so they go out with the
+// next one instead of disappearing
+static void return_report_motion(const mouse_report_t *report)
+{
+    k_spinlock_key_t key = k_spin_lock(&motion_lock);
+    motion_accum_add(&motion_accum, report->x, report->y, report->wheel);
+    k_spin_unlock(&motion_lock, key);
+    report_sched_lost(&report_sched);
+    polling_wake();
+}
+
+// Burst at a link sample point, only while the sensor has motion. Cleared
+// before the read, so a motion IRQ during the burst still counts.
+static void sensor_sample_paced(void)
+{
+    if (!atomic_cas(&sensor_moving, 1, 0))
+    {
+        return;
+    }
+    if (sensor_sample_motion())
+    {
+        atomic_set(&sensor_moving, 1);
+    }
+}
+
+// Wait for the link's sample point (USB frame or BLE connection event) and
+// read the sensor there, so the report carries the freshest motion. Returns
+// whether the loop is paced by the link.
+static bool handle_motion_sync(transport_id_t connection_type)
+{
+    static bool was_usb_synced = false;
+    bool usb_synced = connection_type == TRANSPORT_USB && motion_sync_engaged(MOTION_SYNC_USB);
+    bool ble_synced = connection_type == TRANSPORT_BLE && motion_sync_engaged(MOTION_SYNC_BLE);
+
+    // The wait keeps pacing the loop while idle, only the SPI burst is
+    // skipped until the motion pin fires again
+    if (usb_synced && motion_sync_wait(MOTION_SYNC_USB))
+    {
+        sensor_sample_paced();
+    }
+    else if (ble_synced && motion_sync_wait(MOTION_SYNC_BLE))
+    {
+        sensor_sample_paced();
+    }
+
+    if (was_usb_synced && !usb_synced)
+    {
+        // The sensor thread was parked, let it pick up motion still latched
+        k_sem_give(&motion_sem);
+    }
+
+    was_usb_synced = usb_synced;
+    return usb_synced || ble_synced;
+}
+
+// Build one report if there is something to say and room to queue it.
+// While the tx stage is backed up nothing is taken, so motion and button
+// changes coalesce into the next report instead of piling up.
+static void build_report(const transport_t *transport)
+{
+    mouse_report_t report = {0};
+
+    // GET SCROLL WHEEL
+    add_wheel_motion(get_encoder_increment());
+
+    // GET SCROLL WHEEL BUTTON & MAIN SWITCH STATE
+    // The switch wired as "right" is the primary button
+    report.buttons = (get_switch_state_right() ? MOUSE_BTN_LEFT : 0) |
+                     (get_switch_state_left() ? MOUSE_BTN_RIGHT : 0) |
+                     (get_encoder_button_state() ? MOUSE_BTN_MIDDLE : 0) |
+                     (get_switch_state_forward() ? MOUSE_BTN_FORWARD : 0) |
+                     (get_switch_state_backward() ? MOUSE_BTN_BACK : 0);
+
+    if (transport == NULL || !transport->is_ready())
+    {
+        return;
+    }
+    boot_timing_link_ready(transport_active_id());
+    if (k_msgq_num_free_get(&report_msgq) == 0)
+    {
+        return;
+    }
+
+    // GET CURSOR POSITION
+    get_report_motion(transport->max_report_format(),
+                      &report.x, &report.y, &report.wheel, &report.sample_cycles, &report.latency);
+    report.has_sample = report.x != 0 || report.y != 0;
+    if (report.has_sample)
+    {
+        report.latency.built = k_cycle_get_32();
     }
     else
     {
-        LOG_ERR("Failed to fetch sensor data");
+        report.latency.origin = 0;
+    }
+
+    // Nothing moved, no button changed and nothing lost: no report
+    if (!report_sched_due(&report_sched, &report))
+    {
+        return;
+    }
+    report_sched_sent(&report_sched, &report);
+    led_activity();
+
+    // Only this thread puts, and there was room
+    k_msgq_put(&report_msgq, &report, K_NO_WAIT);
+}
+
+static void report_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1)
+    {
+        // Chosen by the transports' link callbacks, nothing is probed here
+        transport_id_t connection_type = transport_active_id();
+        bool synced = handle_motion_sync(connection_type);
+        const transport_t *transport = transport_active();
+
+        build_report(transport);
+
+        // Link-paced loops already waited for the sample point. Otherwise
+        // sleep until polling_wake(); a link that isn't ready yet (BLE
+        // before CCC enable, ESB before the host) has no event for that,
+        // so it is looked at again now and then.
+        if (!synced)
+        {
+            bool link_pending = transport != NULL && !transport->is_ready();
+            k_sem_take(&report_sem, link_pending ? K_MSEC(HOUSEKEEPING_PERIOD_MS) : K_FOREVER);
+        }
     }
 }
 
+static void tx_thread_fn(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    mouse_report_t report;
+
+    while (1)
+    {
+        k_msgq_get(&report_msgq, &report, K_FOREVER);
+        // A report held back for lack of room can go now
+        polling_wake();
+
+        // The link may have changed since the report was built, the
+        // transport clamps to what it can carry
+        const transport_t *transport = transport_active();
+        int err = transport ? transport->send_report(&report) : -ENOTCONN;
+        if (err)
+        {
+            TRACE(TRACE_EV_TX_ERROR, transport_active_id(), err, 0, 0);
+        }
+        // Anything the link didn't take, including a link gone since the
+        // report was built, is owed to the next one
+        if (err && err != -EINPROGRESS)
+        {
+            return_report_motion(&report);
+        }
+    }
+}
+
+static void pipeline_init(void)
+{
+    k_thread_create(&tx_thread, tx_thread_stack,
+                    K_THREAD_STACK_SIZEOF(tx_thread_stack),
+                    tx_thread_fn, NULL, NULL, NULL,
+                    TX_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&tx_thread, "tx");
+
+    k_thread_create(&report_thread, report_thread_stack,
+                    K_THREAD_STACK_SIZEOF(report_thread_stack),
+                    report_thread_fn, NULL, NULL, NULL,
+                    REPORT_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&report_thread, "report");
+}
+
+// Every step only starts its subsystem and returns: USB enumeration, the
+// BLE controller and the sensor power-up finish in their own threads, and
+// each link takes reports as soon as its own ready event says so
 void polling_init()
 {
     usb_hid_mouse_init();
     encoder_init();
     switch_init();
     led_init();
+#if defined(CONFIG_BT)
     ble_init();
+#endif
+#if defined(CONFIG_MOUSE_ESB)
+    esb_transport_init();
+#endif
     battery_init();
     sensor_cursor_init();
+    pipeline_init();
+    boot_timing_init_done();
 }
 
-void polling_run(void)
+void polling_wake(void)
 {
-    // GET CURSOR POSITION
-    int cursor_position_x = 0;
-    int cursor_position_y = 0;
-    get_cursor_position(&cursor_position_x, &cursor_position_y);
+    k_sem_give(&report_sem);
+}
 
-    // GET SCROLL WHEEL
-    int encoder_increment = get_encoder_increment();
-
-    // GET SCROLL WHEEL BUTTON
-    bool encoder_button_state = get_encoder_button_state();
-
-    // GET MAIN SWITCH STATE
-    bool switch_right_state = get_switch_state_right();
-    bool switch_left_state = get_switch_state_left();
-    bool switch_forward_state = get_switch_state_forward();
-    bool switch_backward_state = get_switch_state_backward();
-
-    send_output_to_host(
-        cursor_position_x,
-        cursor_position_y,
-        encoder_increment,
-        encoder_button_state,
-        switch_right_state,
-        switch_left_state,
-        switch_forward_state,
-        switch_backward_state);
-
-    // GET BATTERY PERCENTAGE
-    int battery_percent = 0;
-    battery_get_percentage(&battery_percent);
+// Housekeeping, runs at the main thread's priority below the input pipeline
+void polling_run(void)
+{
+    // TRACK ACTIVE LINK
+    handle_link_change(transport_active_id());
 
     // HANDLE DPI & LED UPDATE
     bool dpi_button_state = switch_get_state_dpi();
     handle_dpi_button(dpi_button_state);
+    handle_battery_led();
 
-    k_usleep(UPDATE_RATE);
+    k_msleep(HOUSEKEEPING_PERIOD_MS);
 }
@@ -5,5 +5,8 @@
 
 void polling_init();
 void polling_run(void);
+// Input changed, a link came or went, or report_msgq has room: the report
+// stage looks again. ISR safe.
+void polling_wake(void);
 
 #endif
\ No newline at end of file
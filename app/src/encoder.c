@@ -1,4 +1,5 @@
 #include "encoder.h"
+#include "business_logic.h"
 #include <zephyr/kernel.h>
 
 #define SCROLL_A_NODE DT_ALIAS(scrolla)
@@ -52,16 +53,19 @@ static void update_scroll_direction(void)
 static void scroll_a_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
     update_scroll_direction();
+    polling_wake();
 }
 
 static void scroll_b_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
 {
     update_scroll_direction();
+    polling_wake();
 }
 
 static void debounce_btn(struct k_work *work)
 {
     button_pressed = (gpio_pin_get_dt(&scroll_btn) == 0); // active low
+    polling_wake();
 }
 
 static void btn_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
@@ -0,0 +1,98 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "esb_link.h"
+#include "esb_transport.h"
+#include "transport.h"
+#include "latency.h"
+#include "trace.h"
+#include "boot_timing.h"
+
+LOG_MODULE_REGISTER(esb_transport, LOG_LEVEL_INF);
+
+// A report holds the radio for its retransmits at most, this only covers a
+// radio that stopped answering altogether
+#define ESB_TX_TIMEOUT K_MSEC(5)
+
+static struct esb_link link;
+static atomic_t host_ready;
+
+static void esb_ack_payload(struct esb_link *l, const uint8_t *data, size_t len)
+{
+    ARG_UNUSED(l);
+    ARG_UNUSED(len);
+    atomic_set(&host_ready, (data[0] & ESB_LINK_ACK_HOST_READY) != 0);
+}
+
+static void esb_link_state(struct esb_link *l, bool up)
+{
+    ARG_UNUSED(l);
+    if (!up)
+    {
+        atomic_clear(&host_ready);
+    }
+    transport_link_changed(TRANSPORT_ESB, up);
+}
+
+static const struct esb_link_callbacks link_cb = {
+    .ack_payload = esb_ack_payload,
+    .link_state = esb_link_state,
+};
+
+static int esb_send_report(const mouse_report_t *report)
+{
+    const struct esb_link_report wire = {
+        .x = report->x,
+        .y = report->y,
+        .wheel = report->wheel,
+        .buttons = report->buttons,
+    };
+
+    TRACE(TRACE_EV_ESB_REPORT, report->buttons, report->x, report->y, report->wheel);
+    void *latency = latency_tx_start(&report->latency);
+    int err = esb_link_send_report(&link, &wire, ESB_TX_TIMEOUT);
+    if (err == -EINPROGRESS)
+    {
+        // On air without an ACK: the link resends it with its sequence
+        // number, so the receiver drops it if it got it already. Owing the
+        // counts here as well would apply them twice.
+        return err;
+    }
+    if (err)
+    {
+        // Never went out, the counts are still owed
+        return -EIO;
+    }
+    latency_tx_done(latency);
+    boot_timing_report_sent(TRANSPORT_ESB);
+    return 0;
+}
+
+static bool esb_is_ready(void)
+{
+    return esb_link_is_up(&link) && atomic_get(&host_ready);
+}
+
+static report_format_t esb_max_report_format(void)
+{
+    return REPORT_FORMAT_16BIT;
+}
+
+static const transport_t esb_transport = {
+    .name = "esb",
+    .send_report = esb_send_report,
+    .is_ready = esb_is_ready,
+    .max_report_format = esb_max_report_format,
+};
+
+int esb_transport_init(void)
+{
+    transport_register(TRANSPORT_ESB, &esb_transport);
+
+    int err = esb_link_init(&link, esb_radio_nrf_get(), ESB_RADIO_PTX, &link_cb, NULL);
+    if (err)
+    {
+        LOG_ERR("ESB link init failed: %d", err);
+    }
+    return err;
+}
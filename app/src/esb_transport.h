@@ -0,0 +1,17 @@
+#ifndef ESB_TRANSPORT_H
+#define ESB_TRANSPORT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Mouse end of the 2.4 GHz link to the ESB receiver, registered as
+    // TRANSPORT_ESB. Only in builds without Bluetooth (CONFIG_MOUSE_ESB).
+    int esb_transport_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "latency.h"
+#include "transport.h"
+
+LOG_MODULE_REGISTER(latency, LOG_LEVEL_INF);
+
+#if defined(CONFIG_MOUSE_LATENCY_STATS)
+
+// Log-linear buckets: values below 8 us exactly, then 8 buckets per power
+// of two (about 6 % wide) up to 262 ms, where the last bucket catches all
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS 128
+// Reports that can be in flight on a link at once
+#define TX_SLOTS 8
+
+typedef enum
+{
+    STAGE_READ,  // origin -> burst complete
+    STAGE_BUILD, // burst complete -> report built
+    STAGE_TX,    // report built -> link done
+    STAGE_TOTAL, // origin -> link done
+    STAGE_COUNT,
+} latency_stage_t;
+
+static const char *const stage_names[STAGE_COUNT] = {
+    [STAGE_READ] = "irq->read",
+    [STAGE_BUILD] = "read->build",
+    [STAGE_TX] = "build->wire",
+    [STAGE_TOTAL] = "irq->wire",
+};
+
+struct histogram
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t buckets[HIST_BUCKETS];
+};
+
+struct tx_slot
+{
+    latency_stamps_t stamps;
+    bool busy;
+};
+
+static struct k_spinlock lock;
+static struct histogram hist[STAGE_COUNT];
+static struct tx_slot slots[TX_SLOTS];
+static uint8_t next_slot;
+static transport_id_t hist_transport = TRANSPORT_NONE;
+
+static uint32_t bucket_of(uint32_t us)
+{
+    if (us < HIST_SUB)
+    {
+        return us;
+    }
+    uint32_t msb = 31 - __builtin_clz(us);
+    uint32_t idx = (msb - HIST_SUB_BITS + 1) * HIST_SUB + ((us >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+
+    return MIN(idx, HIST_BUCKETS - 1);
+}
+
+// Lower bound of a bucket
+static uint32_t bucket_floor(uint32_t idx)
+{
+    if (idx < HIST_SUB)
+    {
+        return idx;
+    }
+    uint32_t msb = idx / HIST_SUB + HIST_SUB_BITS - 1;
+
+    return (HIST_SUB + idx % HIST_SUB) << (msb - HIST_SUB_BITS);
+}
+
+static void hist_add(struct histogram *h, uint32_t from, uint32_t to)
+{
+    uint32_t us = k_cyc_to_us_floor32(to - from);
+
+    if (h->count == 0 || us < h->min_us)
+    {
+        h->min_us = us;
+    }
+    h->max_us = MAX(h->max_us, us);
+    h->count++;
+    h->buckets[bucket_of(us)]++;
+}
+
+static uint32_t hist_percentile(const struct histogram *h, uint32_t pct)
+{
+    uint32_t rank = (h->count * pct + 99) / 100;
+    uint32_t seen = 0;
+
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= rank)
+        {
+            return CLAMP(bucket_floor(i), h->min_us, h->max_us);
+        }
+    }
+    return h->max_us;
+}
+
+// Caller holds lock
+static void reset_locked(void)
+{
+    memset(hist, 0, sizeof(hist));
+    for (int i = 0; i < TX_SLOTS; i++)
+    {
+        slots[i].busy = false;
+    }
+}
+
+void *latency_tx_start(const latency_stamps_t *stamps)
+{
+    if (stamps->origin == 0)
+    {
+        return NULL;
+    }
+
+    transport_id_t id = transport_active_id();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    // Numbers from different links don't mix
+    if (id != hist_transport)
+    {
+        reset_locked();
+        hist_transport = id;
+    }
+    struct tx_slot *slot = &slots[next_slot];
+    next_slot = (next_slot + 1) % TX_SLOTS;
+    slot->stamps = *stamps;
+    slot->busy = true;
+    k_spin_unlock(&lock, key);
+
+    return slot;
+}
+
+void latency_tx_done(void *token)
+{
+    struct tx_slot *slot = token;
+    uint32_t now = k_cycle_get_32();
+
+    if (slot == NULL)
+    {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (slot->busy)
+    {
+        const latency_stamps_t *s = &slot->stamps;
+
+        hist_add(&hist[STAGE_READ], s->origin, s->read);
+        hist_add(&hist[STAGE_BUILD], s->read, s->built);
+        hist_add(&hist[STAGE_TX], s->built, now);
+        hist_add(&hist[STAGE_TOTAL], s->origin, now);
+        slot->busy = false;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+typedef void (*latency_print_link_t)(void *ctx, const char *link);
+typedef void (*latency_print_t)(void *ctx, const char *name, const struct histogram *h);
+
+// One consistent copy of the histograms and the link they were taken on
+static void latency_walk(latency_print_link_t print_link, latency_print_t print, void *ctx)
+{
+    static struct histogram copy[STAGE_COUNT];
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memcpy(copy, hist, sizeof(copy));
+    transport_id_t id = hist_transport;
+    k_spin_unlock(&lock, key);
+
+    const transport_t *t = transport_get(id);
+    print_link(ctx, t ? t->name : "none");
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        print(ctx, stage_names[i], &copy[i]);
+    }
+}
+
+static void log_print_link(void *ctx, const char *link)
+{
+    ARG_UNUSED(ctx);
+    LOG_INF("latency on %s:", link);
+}
+
+static void log_print(void *ctx, const char *name, const struct histogram *h)
+{
+    ARG_UNUSED(ctx);
+    LOG_INF("%-12s n=%u min %u p50 %u p99 %u max %u us", name, h->count, h->min_us,
+            hist_percentile(h, 50), hist_percentile(h, 99), h->max_us);
+}
+
+void latency_dump(void)
+{
+    latency_walk(log_print_link, log_print, NULL);
+}
+
+void latency_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    reset_locked();
+    k_spin_unlock(&lock, key);
+}
+
+#if CONFIG_MOUSE_LATENCY_STATS_LOG_S > 0
+static void dump_work_handler(struct k_work *work)
+{
+    latency_dump();
+    k_work_schedule(k_work_delayable_from_work(work), K_SECONDS(CONFIG_MOUSE_LATENCY_STATS_LOG_S));
+}
+
+static K_WORK_DELAYABLE_DEFINE(dump_work, dump_work_handler);
+
+static int latency_log_init(void)
+{
+    k_work_schedule(&dump_work, K_SECONDS(CONFIG_MOUSE_LATENCY_STATS_LOG_S));
+    return 0;
+}
+
+SYS_INIT(latency_log_init, APPLICATION, 0);
+#endif
+
+#if defined(CONFIG_SHELL)
+static void shell_print_link(void *ctx, const char *link)
+{
+    shell_print((const struct shell *)ctx, "latency on %s:", link);
+}
+
+static void shell_print_stage(void *ctx, const char *name, const struct histogram *h)
+{
+    shell_print((const struct shell *)ctx, "%-12s n=%u min %u p50 %u p99 %u max %u us", name,
+                h->count, h->min_us, hist_percentile(h, 50), hist_percentile(h, 99), h->max_us);
+}
+
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv)
+{
+    latency_walk(shell_print_link, shell_print_stage, (void *)sh);
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    latency_reset();
+    shell_print(sh, "latency histograms cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(latency_cmds,
+                               SHELL_CMD(show, NULL, "Per-stage latency: min, p50, p99, max", cmd_latency_show),
+                               SHELL_CMD(reset, NULL, "Clear the histograms", cmd_latency_reset),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(latency, &latency_cmds, "Input latency histograms", cmd_latency_show);
+#endif
+
+#else
+void *latency_tx_start(const latency_stamps_t *stamps)
+{
+    ARG_UNUSED(stamps);
+    return NULL;
+}
+
+void latency_tx_done(void *token)
+{
+    ARG_UNUSED(token);
+}
+
+void latency_dump(void)
+{
+}
+
+void latency_reset(void)
+{
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Where the oldest motion in a report has been, in k_cycle_get_32()
+    // cycles. origin is the motion IRQ for a burst the IRQ started, or the
+    // burst start for one read while polling; 0 if the report has no motion.
+    typedef struct
+    {
+        uint32_t origin;
+        uint32_t read;  // burst complete
+        uint32_t built; // report built
+    } latency_stamps_t;
+
+    // The transport hands the report to its link. Returns a token for
+    // latency_tx_done(), NULL when there is nothing to measure.
+    void *latency_tx_start(const latency_stamps_t *stamps);
+
+    // The link finished the report: USB IN transfer read by the host, BLE
+    // notification sent, ESB packet ACKed. Any context.
+    void latency_tx_done(void *token);
+
+    // Log the histograms now, they keep accumulating
+    void latency_dump(void);
+    // Clear the histograms
+    void latency_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,20 +5,75 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/drivers/gpio.h>
+#include <math.h>
+#include <string.h>
 
 LOG_MODULE_REGISTER(led, LOG_LEVEL_DBG);
 
 #define STRIP_NODE DT_ALIAS(ledstrip)
 #define GLOW_EN_NODE DT_ALIAS(glow_en)
+#define STRIP_LENGTH DT_PROP(STRIP_NODE, chain_length)
+
+// Engine: one work item on its own queue below every input thread (and
+// main). It renders a frame from the current state, pushes it only if it
+// differs from the one on the strip, and reschedules itself only while
+// something is animating or an idle step is due.
+#define LED_WQ_STACK_SIZE 1024
+#define LED_WQ_PRIORITY K_PRIO_PREEMPT(10)
+#define LED_FRAME_MS 20
+#define LED_GAMMA 2.2f
+
+#define LED_BREATHE_PERIOD_MS 3000
+#define LED_FLASH_MS 300
+#define LED_FLASH_TOGGLE_MS 75
+#define LED_BATT_BLINK_PERIOD_MS 4000
+#define LED_BATT_BLINK_ON_MS 150
 
 static const struct device *strip = DEVICE_DT_GET(STRIP_NODE);
-static struct led_rgb pixel[5];
+
+// frames[front] is what the strip shows, the next one is rendered into the
+// other; the driver may scribble over what it sends, so it gets a copy
+static struct led_rgb frames[2][STRIP_LENGTH];
+static struct led_rgb tx_frame[STRIP_LENGTH];
+static uint8_t front;
+static bool frame_valid;
+
+// gamma and the current brightness folded into one table
+static uint8_t gamma_lut[256];
+static uint8_t output_lut[256];
+static uint8_t output_percent;
+
+K_THREAD_STACK_DEFINE(led_wq_stack, LED_WQ_STACK_SIZE);
+static struct k_work_q led_wq;
+static bool engine_ready;
+static void led_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(led_work, led_work_handler);
+
+// Written from any thread, read by the engine
+static struct k_spinlock state_lock;
+static struct
+{
+    led_rgb_t base;
+    led_effect_t effect;
+    led_rgb_t flash;
+    uint32_t flash_start;
+    bool flashing;
+    bool battery_low;
+} state;
+
+static atomic_t last_activity;
+static atomic_t idle; // engine dimmed or switched off, wake on activity
 
 static const struct gpio_dt_spec glow_en_dev = GPIO_DT_SPEC_GET_OR(GLOW_EN_NODE, gpios, {0});
+static bool glow_on;
 
-static void glow_enable(void)
+static void glow_set(bool on)
 {
-    gpio_pin_set_dt(&glow_en_dev, 1);
+    if (glow_on != on && glow_en_dev.port)
+    {
+        gpio_pin_set_dt(&glow_en_dev, on);
+        glow_on = on;
+    }
 }
 
 static void glow_en_init(void)
@@ -34,7 +89,7 @@ static void glow_en_init(void)
         LOG_ERR("Failed to configure glow enable pin: %d", ret);
         return;
     }
-    glow_enable();
+    glow_on = true;
     LOG_INF("Glow enable initialized");
 }
 
@@ -48,6 +103,164 @@ static const led_rgb_t led_colors[LED_COLOR_COUNT] = {
     [LED_COLOR_CYAN] = {.r = 0, .g = 255, .b = 255},
     [LED_COLOR_PURPLE] = {.r = 128, .g = 0, .b = 128}};
 
+static led_rgb_t color_rgb(led_color_t color)
+{
+    if (color >= LED_COLOR_COUNT)
+    {
+        LOG_WRN("Invalid LED color: %d", color);
+        color = LED_COLOR_OFF;
+    }
+    return led_colors[color];
+}
+
+static void build_output_lut(uint8_t percent)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        output_lut[i] = (gamma_lut[i] * percent + 50) / 100;
+    }
+    output_percent = percent;
+}
+
+static void led_kick(void)
+{
+    if (engine_ready)
+    {
+        k_work_reschedule_for_queue(&led_wq, &led_work, K_NO_WAIT);
+    }
+}
+
+// Brightness for the time since the last input, and when the next step is due
+static uint8_t idle_percent(uint32_t idle_ms, int32_t *next_ms)
+{
+    const uint32_t dim_ms = CONFIG_MOUSE_LED_IDLE_DIM_S * MSEC_PER_SEC;
+    const uint32_t off_ms = CONFIG_MOUSE_LED_IDLE_OFF_S * MSEC_PER_SEC;
+
+    if (idle_ms < dim_ms)
+    {
+        *next_ms = dim_ms - idle_ms;
+        return 100;
+    }
+    if (idle_ms < off_ms)
+    {
+        *next_ms = off_ms - idle_ms;
+        return CONFIG_MOUSE_LED_DIM_PERCENT;
+    }
+    *next_ms = -1;
+    return 0;
+}
+
+static led_rgb_t scale(led_rgb_t c, uint8_t level)
+{
+    return (led_rgb_t){
+        .r = (c.r * level) / 255,
+        .g = (c.g * level) / 255,
+        .b = (c.b * level) / 255,
+    };
+}
+
+// Render the frame for time now into frame, returns whether it animates
+static bool render(struct led_rgb *frame, uint32_t now)
+{
+    k_spinlock_key_t key = k_spin_lock(&state_lock);
+    led_rgb_t c = state.base;
+    bool animating = false;
+
+    if (state.effect == LED_EFFECT_BREATHE)
+    {
+        // Triangle wave, gamma makes it look like a smooth fade
+        uint32_t phase = now % LED_BREATHE_PERIOD_MS;
+        uint32_t half = LED_BREATHE_PERIOD_MS / 2;
+        uint32_t level = phase < half ? phase * 255 / half : (LED_BREATHE_PERIOD_MS - phase) * 255 / half;
+        c = scale(c, level);
+        animating = true;
+    }
+
+    if (state.flashing)
+    {
+        uint32_t t = now - state.flash_start;
+        if (t < LED_FLASH_MS)
+        {
+            c = (t / LED_FLASH_TOGGLE_MS) % 2 ? (led_rgb_t){0} : state.flash;
+            animating = true;
+        }
+        else
+        {
+            state.flashing = false;
+        }
+    }
+
+    if (state.battery_low)
+    {
+        if (now % LED_BATT_BLINK_PERIOD_MS < LED_BATT_BLINK_ON_MS)
+        {
+            c = led_colors[LED_COLOR_RED];
+        }
+        animating = true;
+    }
+    k_spin_unlock(&state_lock, key);
+
+    memset(frame, 0, sizeof(frames[0]));
+    frame[0].r = output_lut[c.r];
+    frame[0].g = output_lut[c.g];
+    frame[0].b = output_lut[c.b];
+    return animating;
+}
+
+static void led_push(const struct led_rgb *frame)
+{
+    // Only the first pixel is fitted, but the chain is shifted out as a whole
+    memcpy(tx_frame, frame, sizeof(tx_frame));
+    int ret = led_strip_update_rgb(strip, tx_frame, STRIP_LENGTH);
+    if (ret)
+    {
+        LOG_ERR("Failed to update LED strip: %d", ret);
+        frame_valid = false;
+    }
+}
+
+static void led_work_handler(struct k_work *work)
+{
+    uint32_t now = k_uptime_get_32();
+    int32_t next_idle_ms;
+    uint8_t percent = idle_percent(now - (uint32_t)atomic_get(&last_activity), &next_idle_ms);
+
+    atomic_set(&idle, percent < 100);
+    if (percent != output_percent)
+    {
+        build_output_lut(percent);
+    }
+
+    uint8_t back = front ^ 1;
+    bool animating = render(frames[back], now) && percent > 0;
+
+    if (percent > 0)
+    {
+        glow_set(true);
+    }
+    if (!frame_valid || memcmp(frames[back], frames[front], sizeof(frames[0])) != 0)
+    {
+        led_push(frames[back]);
+        front = back;
+        frame_valid = true;
+    }
+    if (percent == 0)
+    {
+        // Strip is dark, cut its supply until the next input
+        glow_set(false);
+        frame_valid = false;
+    }
+
+    if (animating)
+    {
+        k_work_schedule_for_queue(&led_wq, &led_work, K_MSEC(LED_FRAME_MS));
+    }
+    else if (next_idle_ms >= 0)
+    {
+        k_work_schedule_for_queue(&led_wq, &led_work, K_MSEC(next_idle_ms));
+    }
+}
+
 void led_init(void)
 {
     glow_en_init();
@@ -57,31 +270,74 @@ void led_init(void)
         LOG_ERR("LED strip device not ready");
         return;
     }
+
+    for (int i = 0; i < 256; i++)
+    {
+        gamma_lut[i] = (uint8_t)(powf(i / 255.0f, LED_GAMMA) * 255.0f + 0.5f);
+    }
+    build_output_lut(100);
+    atomic_set(&last_activity, k_uptime_get_32());
+
+    k_work_queue_start(&led_wq, led_wq_stack, K_THREAD_STACK_SIZEOF(led_wq_stack),
+                       LED_WQ_PRIORITY, NULL);
+    k_thread_name_set(&led_wq.thread, "led");
+    engine_ready = true;
+
     LOG_INF("LED strip initialized");
     led_set_color(LED_COLOR_OFF);
 }
 
 void led_set_rgb(uint8_t r, uint8_t g, uint8_t b)
 {
-    pixel[0].r = r;
-    pixel[0].g = g;
-    pixel[0].b = b;
+    k_spinlock_key_t key = k_spin_lock(&state_lock);
+    state.base = (led_rgb_t){.r = r, .g = g, .b = b};
+    k_spin_unlock(&state_lock, key);
+    led_kick();
+}
 
-    int ret = led_strip_update_rgb(strip, pixel, ARRAY_SIZE(pixel));
-    if (ret)
+void led_set_color(led_color_t color)
+{
+    led_rgb_t rgb = color_rgb(color);
+    led_set_rgb(rgb.r, rgb.g, rgb.b);
+}
+
+void led_set_effect(led_effect_t effect)
+{
+    k_spinlock_key_t key = k_spin_lock(&state_lock);
+    state.effect = effect;
+    k_spin_unlock(&state_lock, key);
+    led_kick();
+}
+
+void led_flash(led_color_t color)
+{
+    k_spinlock_key_t key = k_spin_lock(&state_lock);
+    state.flash = color_rgb(color);
+    state.flash_start = k_uptime_get_32();
+    state.flashing = true;
+    k_spin_unlock(&state_lock, key);
+    led_activity();
+    led_kick();
+}
+
+void led_set_battery_low(bool low)
+{
+    k_spinlock_key_t key = k_spin_lock(&state_lock);
+    bool changed = state.battery_low != low;
+    state.battery_low = low;
+    k_spin_unlock(&state_lock, key);
+
+    if (changed)
     {
-        LOG_ERR("Failed to update LED strip: %d", ret);
+        led_kick();
     }
 }
 
-void led_set_color(led_color_t color)
+void led_activity(void)
 {
-    if (color >= LED_COLOR_COUNT)
+    atomic_set(&last_activity, k_uptime_get_32());
+    if (atomic_cas(&idle, 1, 0))
     {
-        LOG_WRN("Invalid LED color: %d", color);
-        color = LED_COLOR_OFF;
+        led_kick();
     }
-
-    led_rgb_t rgb = led_colors[color];
-    led_set_rgb(rgb.r, rgb.g, rgb.b);
 }
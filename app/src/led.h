@@ -2,6 +2,7 @@
 #define LED_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct {
     uint8_t r;
@@ -21,8 +22,26 @@ typedef enum {
     LED_COLOR_COUNT  // For iteration or validation
 } led_color_t;
 
+typedef enum {
+    LED_EFFECT_SOLID,
+    LED_EFFECT_BREATHE,
+} led_effect_t;
+
+// All of these only update the engine's state and return; frames are
+// rendered and pushed from the LED work queue below the input pipeline.
 void led_init(void);
 void led_set_rgb(uint8_t r, uint8_t g, uint8_t b);
 void led_set_color(led_color_t color);
+void led_set_effect(led_effect_t effect);
+
+// Blink the given color a few times, then go back to the base color
+void led_flash(led_color_t color);
+
+// Short red blink every few seconds on top of everything else
+void led_set_battery_low(bool low);
+
+// User input: restores full brightness after an idle dim or off. Cheap
+// enough for the report path.
+void led_activity(void);
 
 #endif // LED_H
@@ -0,0 +1,45 @@
+#include <zephyr/sys/util.h>
+
+#include "motion_accum.h"
+
+// Largest value each report format can carry on X/Y (symmetric range)
+#define REPORT_8BIT_XY_MAX INT8_MAX
+#define REPORT_16BIT_XY_MAX INT16_MAX
+// The wheel is 8 bits in every format
+#define REPORT_WHEEL_MAX INT8_MAX
+
+static int32_t take_chunk(int32_t *pending, int32_t limit)
+{
+    int32_t chunk = CLAMP(*pending, -limit, limit);
+    *pending -= chunk;
+    return chunk;
+}
+
+void motion_accum_add(motion_accum_t *acc, int32_t dx, int32_t dy, int32_t wheel)
+{
+    acc->x += dx;
+    acc->y += dy;
+    acc->wheel += wheel;
+}
+
+void motion_accum_take(motion_accum_t *acc, report_format_t format,
+                       int16_t *dx, int16_t *dy, int8_t *wheel)
+{
+    int32_t limit = (format == REPORT_FORMAT_16BIT) ? REPORT_16BIT_XY_MAX : REPORT_8BIT_XY_MAX;
+
+    *dx = (int16_t)take_chunk(&acc->x, limit);
+    *dy = (int16_t)take_chunk(&acc->y, limit);
+    *wheel = (int8_t)take_chunk(&acc->wheel, REPORT_WHEEL_MAX);
+}
+
+bool motion_accum_pending(const motion_accum_t *acc)
+{
+    return acc->x != 0 || acc->y != 0 || acc->wheel != 0;
+}
+
+void motion_accum_reset(motion_accum_t *acc)
+{
+    acc->x = 0;
+    acc->y = 0;
+    acc->wheel = 0;
+}
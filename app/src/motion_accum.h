@@ -0,0 +1,38 @@
+#ifndef MOTION_ACCUM_H
+#define MOTION_ACCUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Width of the X/Y fields in the report the active transport sends
+    typedef enum
+    {
+        REPORT_FORMAT_8BIT,  // BLE boot protocol
+        REPORT_FORMAT_16BIT, // USB, BLE report protocol, ESB
+    } report_format_t;
+
+    // Motion integrated in 32 bits between reports. Counts that do not fit
+    // in one report stay here and go out with the next one.
+    typedef struct
+    {
+        int32_t x;
+        int32_t y;
+        int32_t wheel;
+    } motion_accum_t;
+
+    void motion_accum_add(motion_accum_t *acc, int32_t dx, int32_t dy, int32_t wheel);
+    void motion_accum_take(motion_accum_t *acc, report_format_t format,
+                           int16_t *dx, int16_t *dy, int8_t *wheel);
+    bool motion_accum_pending(const motion_accum_t *acc);
+    void motion_accum_reset(motion_accum_t *acc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTION_ACCUM_H
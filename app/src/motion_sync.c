@@ -0,0 +1,143 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+#include "motion_sync.h"
+
+LOG_MODULE_REGISTER(motion_sync, LOG_LEVEL_INF);
+
+// Full-speed USB frame
+#define USB_FRAME_US 1000
+// Gap in sync events after which we fall back to free-running sampling.
+// BLE allows for a few missed connection events at 7.5-8.75 ms.
+#define SOF_TIMEOUT_MS 3
+#define CONN_EVENT_TIMEOUT_MS 40
+
+struct sync_source
+{
+    struct k_sem sem;
+    volatile bool seen;
+    volatile uint32_t last_ms;
+    uint32_t timeout_ms;
+    bool enabled;
+};
+
+static struct sync_source sources[] = {
+    [MOTION_SYNC_USB] = {
+        .sem = Z_SEM_INITIALIZER(sources[MOTION_SYNC_USB].sem, 0, 1),
+        .timeout_ms = SOF_TIMEOUT_MS,
+        .enabled = IS_ENABLED(CONFIG_MOUSE_MOTION_SYNC),
+    },
+    [MOTION_SYNC_BLE] = {
+        .sem = Z_SEM_INITIALIZER(sources[MOTION_SYNC_BLE].sem, 0, 1),
+        .timeout_ms = CONN_EVENT_TIMEOUT_MS,
+        .enabled = IS_ENABLED(CONFIG_MOUSE_BLE_CONN_SYNC),
+    },
+};
+
+static void sync_source_signal(struct sync_source *src)
+{
+    src->last_ms = k_uptime_get_32();
+    src->seen = true;
+    k_sem_give(&src->sem);
+}
+
+#if defined(CONFIG_MOUSE_MOTION_SYNC)
+static void sample_timer_expiry(struct k_timer *timer)
+{
+    sync_source_signal(&sources[MOTION_SYNC_USB]);
+}
+
+static K_TIMER_DEFINE(sample_timer, sample_timer_expiry, NULL);
+#endif
+
+void motion_sync_sof(void)
+{
+#if defined(CONFIG_MOUSE_MOTION_SYNC)
+    // Read the sensor just early enough for the report to be queued before
+    // the host polls in the next frame
+    k_timer_start(&sample_timer, K_USEC(USB_FRAME_US - CONFIG_MOUSE_MOTION_SYNC_LEAD_US), K_NO_WAIT);
+#endif
+}
+
+void motion_sync_conn_event(void)
+{
+    // The controller already gives us the lead time we asked for
+    sync_source_signal(&sources[MOTION_SYNC_BLE]);
+}
+
+bool motion_sync_engaged(motion_sync_source_t source)
+{
+    const struct sync_source *src = &sources[source];
+
+    return src->enabled && src->seen && (k_uptime_get_32() - src->last_ms) < src->timeout_ms;
+}
+
+bool motion_sync_wait(motion_sync_source_t source)
+{
+    struct sync_source *src = &sources[source];
+
+    return k_sem_take(&src->sem, K_MSEC(src->timeout_ms)) == 0;
+}
+
+#if defined(CONFIG_MOUSE_REPORT_AGE_STATS)
+static bool queued;
+static uint32_t queued_sample_cycles;
+static uint32_t age_count;
+static uint32_t age_min_us;
+static uint32_t age_max_us;
+static uint64_t age_sum_us;
+static uint64_t age_sum_sq_us;
+
+void motion_sync_report_queued(bool has_sample, uint32_t sample_cycles)
+{
+    queued_sample_cycles = sample_cycles;
+    queued = has_sample;
+}
+
+// IN transfer complete (USB device stack thread): the host has just read the
+// report, so its age is the time since the newest sample in it was taken
+void motion_sync_report_sent(void)
+{
+    if (!queued)
+    {
+        return;
+    }
+    queued = false;
+
+    uint32_t age_us = k_cyc_to_us_floor32(k_cycle_get_32() - queued_sample_cycles);
+    if (age_count == 0)
+    {
+        age_min_us = age_us;
+        age_max_us = age_us;
+        age_sum_us = 0;
+        age_sum_sq_us = 0;
+    }
+    age_min_us = MIN(age_min_us, age_us);
+    age_max_us = MAX(age_max_us, age_us);
+    age_sum_us += age_us;
+    age_sum_sq_us += (uint64_t)age_us * age_us;
+
+    if (++age_count < CONFIG_MOUSE_REPORT_AGE_STATS_WINDOW)
+    {
+        return;
+    }
+
+    uint32_t mean_us = age_sum_us / age_count;
+    uint64_t variance = age_sum_sq_us / age_count - (uint64_t)mean_us * mean_us;
+    LOG_INF("report age (sync %s): mean %u us, stddev %u us, min %u us, max %u us over %u reports",
+            motion_sync_engaged(MOTION_SYNC_USB) ? "on" : "off", mean_us, (uint32_t)sqrtf((float)variance),
+            age_min_us, age_max_us, age_count);
+    age_count = 0;
+}
+#else
+void motion_sync_report_queued(bool has_sample, uint32_t sample_cycles)
+{
+    ARG_UNUSED(has_sample);
+    ARG_UNUSED(sample_cycles);
+}
+
+void motion_sync_report_sent(void)
+{
+}
+#endif
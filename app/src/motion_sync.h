@@ -0,0 +1,45 @@
+#ifndef MOTION_SYNC_H
+#define MOTION_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Events the report path can be paced to
+    typedef enum
+    {
+        MOTION_SYNC_USB, // USB frame, CONFIG_MOUSE_MOTION_SYNC
+        MOTION_SYNC_BLE, // BLE connection event, CONFIG_MOUSE_BLE_CONN_SYNC
+    } motion_sync_source_t;
+
+    // USB start-of-frame, called from the HID class SOF callback in the USB
+    // device stack thread
+    void motion_sync_sof(void);
+
+    // Radio about to serve a BLE connection event, called from the
+    // controller's prepare notification
+    void motion_sync_conn_event(void);
+
+    // Whether sampling currently follows the given source
+    bool motion_sync_engaged(motion_sync_source_t source);
+
+    // Block until the next sample point of the source: USB reads
+    // CONFIG_MOUSE_MOTION_SYNC_LEAD_US before the coming frame, BLE
+    // CONFIG_MOUSE_BLE_CONN_SYNC_PREPARE_US before the connection event.
+    // Returns false if the source went quiet.
+    bool motion_sync_wait(motion_sync_source_t source);
+
+    // Report-age bookkeeping: the newest sensor sample in a report queued
+    // on the IN endpoint, and the host picking that report up
+    void motion_sync_report_queued(bool has_sample, uint32_t sample_cycles);
+    void motion_sync_report_sent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
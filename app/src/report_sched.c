@@ -0,0 +1,20 @@
+#include "report_sched.h"
+
+bool report_sched_due(report_sched_t *sched, const mouse_report_t *report)
+{
+    bool has_motion = report->x != 0 || report->y != 0 || report->wheel != 0;
+    bool buttons_changed = report->buttons != sched->sent_buttons;
+
+    return has_motion || buttons_changed || atomic_get(&sched->lost);
+}
+
+void report_sched_sent(report_sched_t *sched, const mouse_report_t *report)
+{
+    sched->sent_buttons = report->buttons;
+    atomic_clear(&sched->lost);
+}
+
+void report_sched_lost(report_sched_t *sched)
+{
+    atomic_set(&sched->lost, 1);
+}
@@ -0,0 +1,38 @@
+#ifndef REPORT_SCHED_H
+#define REPORT_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/sys/atomic.h>
+
+#include "transport.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // When a report is worth sending, the same rule for every transport: it
+    // carries motion or scroll, or the buttons differ from what the host
+    // last got. A delta is never compared with the previous one, so steady
+    // motion that repeats the same dx/dy goes out every time, and a report
+    // with nothing new is never sent.
+    typedef struct
+    {
+        uint8_t sent_buttons;
+        atomic_t lost; // the link lost a report, repeat the buttons
+    } report_sched_t;
+
+    bool report_sched_due(report_sched_t *sched, const mouse_report_t *report);
+    void report_sched_sent(report_sched_t *sched, const mouse_report_t *report);
+
+    // The transport couldn't deliver a report. Its counts are owed again
+    // separately; this makes the next report go out even without a change.
+    // Any thread.
+    void report_sched_lost(report_sched_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPORT_SCHED_H
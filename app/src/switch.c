@@ -3,6 +3,7 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/gpio.h>
 #include "switch.h"
+#include "business_logic.h"
 
 #define LEFT_SWITCH_NODE DT_ALIAS(sw0)
 #define RIGHT_SWITCH_NODE DT_ALIAS(sw1)
@@ -40,21 +41,25 @@ static void debounce_left(struct k_work *work)
 {
     // Active-low: pressed when pin reads 0
     left_pressed = (gpio_pin_get_dt(&left_switch) == 1);
+    polling_wake();
 }
 
 static void debounce_right(struct k_work *work)
 {
     right_pressed = (gpio_pin_get_dt(&right_switch) == 1);
+    polling_wake();
 }
 
 static void debounce_forward(struct k_work *work)
 {
     forward_pressed = (gpio_pin_get_dt(&forward_switch) == 1);
+    polling_wake();
 }
 
 static void debounce_backward(struct k_work *work)
 {
     backward_pressed = (gpio_pin_get_dt(&backward_switch) == 1);
+    polling_wake();
 }
 
 static void debounce_dpi(struct k_work *work)
@@ -0,0 +1,92 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "trace.h"
+
+#if defined(CONFIG_MOUSE_TRACE)
+
+BUILD_ASSERT(sizeof(trace_record_t) == 16, "dump format expects 16-byte records");
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_MOUSE_TRACE_RING_SIZE), "ring size must be a power of two");
+
+#define TRACE_MASK (CONFIG_MOUSE_TRACE_RING_SIZE - 1)
+#define TRACE_FORMAT_VERSION 1
+
+// Writers claim a slot with one atomic increment and never wait; a reader
+// only has to cope with a slot being rewritten under it, which it detects
+// from seq before and after its copy
+static trace_record_t ring[CONFIG_MOUSE_TRACE_RING_SIZE];
+static atomic_t head;
+
+void trace_emit(uint8_t event, uint8_t a8, int16_t x, int16_t y, int16_t z)
+{
+    uint32_t seq = (uint32_t)atomic_inc(&head);
+    trace_record_t *rec = &ring[seq & TRACE_MASK];
+
+    rec->seq = UINT32_MAX;
+    compiler_barrier();
+    rec->cycles = k_cycle_get_32();
+    rec->event = event;
+    rec->a8 = a8;
+    rec->x = x;
+    rec->y = y;
+    rec->z = z;
+    compiler_barrier();
+    rec->seq = seq;
+}
+
+#if defined(CONFIG_SHELL)
+// Hex lines for scripts/trace_decode.py: a header with the format version,
+// cycle clock and record count, then one record per line
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t end = (uint32_t)atomic_get(&head);
+    uint32_t start = end > CONFIG_MOUSE_TRACE_RING_SIZE ? end - CONFIG_MOUSE_TRACE_RING_SIZE : 0;
+
+    shell_print(sh, "TRACE %d %u %u", TRACE_FORMAT_VERSION, sys_clock_hw_cycles_per_sec(),
+                end - start);
+    for (uint32_t seq = start; seq != end; seq++)
+    {
+        volatile trace_record_t *slot = &ring[seq & TRACE_MASK];
+        trace_record_t rec;
+        const uint8_t *b = (const uint8_t *)&rec;
+
+        // Seqlock-style: the record is only whole if seq still matches after
+        // the copy. Overwritten or still being written since we started.
+        if (slot->seq != seq)
+        {
+            continue;
+        }
+        compiler_barrier();
+        memcpy(&rec, (const void *)slot, sizeof(rec));
+        compiler_barrier();
+        if (slot->seq != seq)
+        {
+            continue;
+        }
+        rec.seq = seq;
+        shell_print(sh, "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+                    b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                    b[8], b[9], b[10], b[11], b[12], b[13], b[14], b[15]);
+    }
+    shell_print(sh, "END");
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    memset(ring, 0xFF, sizeof(ring));
+    shell_print(sh, "trace cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(trace_cmds,
+                               SHELL_CMD(dump, NULL, "Dump the ring for scripts/trace_decode.py", cmd_trace_dump),
+                               SHELL_CMD(clear, NULL, "Drop recorded events", cmd_trace_clear),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(trace, &trace_cmds, "Binary hot-path trace", NULL);
+#endif
+#endif
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Hot-path events. Values are part of the dump format, append only and
+    // keep scripts/trace_decode.py in step.
+    typedef enum
+    {
+        TRACE_EV_USB_REPORT = 1,      // a8 buttons, x, y, z wheel
+        TRACE_EV_BLE_NOTIFY = 2,      // a8 buttons, x, y, z wheel
+        TRACE_EV_BLE_NOTIFY_BOOT = 3, // a8 buttons, x, y, z wheel
+        TRACE_EV_ESB_REPORT = 4,      // a8 buttons, x, y, z wheel
+        TRACE_EV_TX_ERROR = 5,        // a8 transport_id_t, x error
+    } trace_event_t;
+
+    // One fixed-size record. seq is written last and is the record's index
+    // in the stream, so the dump can tell a slot being overwritten.
+    typedef struct
+    {
+        uint32_t seq;
+        uint32_t cycles;
+        uint8_t event;
+        uint8_t a8;
+        int16_t x;
+        int16_t y;
+        int16_t z;
+    } trace_record_t;
+
+#if defined(CONFIG_MOUSE_TRACE)
+    void trace_emit(uint8_t event, uint8_t a8, int16_t x, int16_t y, int16_t z);
+
+    // Binary records cost a few stores, no formatting. Compiled out
+    // without CONFIG_MOUSE_TRACE.
+    #define TRACE(event, a8, x, y, z) trace_emit((event), (a8), (x), (y), (z))
+#else
+    #define TRACE(event, a8, x, y, z) \
+        do                            \
+        {                             \
+        } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
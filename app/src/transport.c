@@ -0,0 +1,71 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "transport.h"
+#include "business_logic.h"
+
+LOG_MODULE_REGISTER(transport, LOG_LEVEL_INF);
+
+static const transport_t *transports[TRANSPORT_COUNT];
+static bool link_up[TRANSPORT_COUNT];
+static struct k_spinlock lock;
+
+// Read lock-free from the report path
+static atomic_t active_id = ATOMIC_INIT(TRANSPORT_NONE);
+
+void transport_register(transport_id_t id, const transport_t *transport)
+{
+    __ASSERT_NO_MSG(id < TRANSPORT_COUNT);
+    transports[id] = transport;
+}
+
+void transport_link_changed(transport_id_t id, bool up)
+{
+    __ASSERT_NO_MSG(id < TRANSPORT_COUNT);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    link_up[id] = up;
+
+    transport_id_t next = TRANSPORT_NONE;
+    for (int i = 0; i < TRANSPORT_COUNT; i++)
+    {
+        if (link_up[i] && transports[i] != NULL)
+        {
+            next = i;
+            break;
+        }
+    }
+    transport_id_t prev = atomic_set(&active_id, next);
+    k_spin_unlock(&lock, key);
+
+    if (next == prev)
+    {
+        return;
+    }
+    polling_wake();
+
+    if (prev != TRANSPORT_NONE && transports[prev]->on_link_change)
+    {
+        transports[prev]->on_link_change(false);
+    }
+    if (next != TRANSPORT_NONE && transports[next]->on_link_change)
+    {
+        transports[next]->on_link_change(true);
+    }
+    LOG_INF("Active transport: %s", next == TRANSPORT_NONE ? "none" : transports[next]->name);
+}
+
+transport_id_t transport_active_id(void)
+{
+    return atomic_get(&active_id);
+}
+
+const transport_t *transport_active(void)
+{
+    return transport_get(atomic_get(&active_id));
+}
+
+const transport_t *transport_get(transport_id_t id)
+{
+    return id == TRANSPORT_NONE ? NULL : transports[id];
+}
@@ -0,0 +1,80 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/sys/util.h>
+
+#include "motion_accum.h"
+#include "latency.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Button bits of mouse_report_t, in the BLE report's HID button order.
+    // The USB report swaps back and forward, see usb_hid.c.
+    #define MOUSE_BTN_LEFT BIT(0)
+    #define MOUSE_BTN_RIGHT BIT(1)
+    #define MOUSE_BTN_MIDDLE BIT(2)
+    #define MOUSE_BTN_BACK BIT(3)
+    #define MOUSE_BTN_FORWARD BIT(4)
+
+    // Links in order of preference: the highest one that is up carries the
+    // reports
+    typedef enum
+    {
+        TRANSPORT_USB,
+        TRANSPORT_ESB,
+        TRANSPORT_BLE,
+        TRANSPORT_COUNT,
+        TRANSPORT_NONE = TRANSPORT_COUNT,
+    } transport_id_t;
+
+    // One report as built by the report stage, the transport encodes it for
+    // its own wire format
+    typedef struct
+    {
+        int16_t x;
+        int16_t y;
+        int8_t wheel;
+        uint8_t buttons;        // MOUSE_BTN_*
+        bool has_sample;        // x/y carry sensor motion
+        uint32_t sample_cycles; // when the newest of it was read
+        latency_stamps_t latency; // the oldest of it, see latency.h
+    } mouse_report_t;
+
+    typedef struct
+    {
+        const char *name;
+        // Queue or send one report, may block on the link. 0 or -EINPROGRESS
+        // (the link delivers it later by itself) means the transport has it;
+        // on any other error its counts go out with the next report.
+        int (*send_report)(const mouse_report_t *report);
+        // Whether the host is ready to take reports right now
+        bool (*is_ready)(void);
+        // Widest X/Y the link can carry at the moment
+        report_format_t (*max_report_format)(void);
+        // Called when the transport becomes the active one or stops being it
+        void (*on_link_change)(bool active);
+    } transport_t;
+
+    void transport_register(transport_id_t id, const transport_t *transport);
+
+    // Link state from the transports' own connect/disconnect callbacks,
+    // may be called from ISR context
+    void transport_link_changed(transport_id_t id, bool up);
+
+    // Cached selection, no link probing
+    transport_id_t transport_active_id(void);
+    const transport_t *transport_active(void);
+
+    // Registered transport for an ID, NULL for TRANSPORT_NONE or none
+    const transport_t *transport_get(transport_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
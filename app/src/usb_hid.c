@@ -1,153 +1,503 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
-#include <zephyr/usb/usb_device.h>
-#include <zephyr/usb/class/usb_hid.h>
+#include <zephyr/drivers/usb/udc_buf.h>
+#include <zephyr/usb/class/usbd_hid.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "usb_hid.h"
+#include "usb_stack.h"
+#include "motion_sync.h"
+#include "transport.h"
+#include "latency.h"
+#include "trace.h"
+#include "boot_timing.h"
 
 LOG_MODULE_REGISTER(usb_hid_c, LOG_LEVEL_INF);
 
-const struct device *hid_dev;
-static const uint8_t hid_report_desc[] = HID_MOUSE_REPORT_DESC(5);
-static K_SEM_DEFINE(ep_write_sem, 0, 1);
-
-static uint8_t last_report[USB_MOUSE_REPORT_SIZE] = {0};
+static const struct device *const hid_dev = DEVICE_DT_GET(DT_NODELABEL(hid_mouse));
+
+// Wheel counts the host gets per detent once it has switched the Resolution
+// Multiplier on
+#define WHEEL_MULTIPLIER CONFIG_MOUSE_WHEEL_COUNTS_PER_DETENT
+
+// No report ID: buttons, X and Y in 16 bits, wheel, AC Pan, 7 bytes. One
+// feature byte carries the wheel's Resolution Multiplier. Unlike the 6-byte
+// BLE report there is AC Pan, and forward/back are buttons 4/5.
+static const uint8_t hid_report_desc[] = {
+    0x05, 0x01, // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02, // Usage (Mouse)
+    0xA1, 0x01, // Collection (Application)
+    0x09, 0x01, //   Usage (Pointer)
+    0xA1, 0x00, //   Collection (Physical)
+
+    // Buttons
+    0x95, 0x05, //     Report Count (5 buttons)
+    0x75, 0x01, //     Report Size (1)
+    0x15, 0x00, //     Logical Minimum (0)
+    0x25, 0x01, //     Logical Maximum (1)
+    0x05, 0x09, //     Usage Page (Button)
+    0x19, 0x01, //     Usage Minimum (Button 1)
+    0x29, 0x05, //     Usage Maximum (Button 5)
+    0x81, 0x02, //     Input (Data,Var,Abs)
+
+    // Padding
+    0x95, 0x01, //     Report Count (1)
+    0x75, 0x03, //     Report Size (3 bits padding)
+    0x81, 0x03, //     Input (Cnst,Var,Abs)
+
+    // X, Y
+    0x05, 0x01,       //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0x80, //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F, //     Logical Maximum (32767)
+    0x75, 0x10,       //     Report Size (16)
+    0x95, 0x02,       //     Report Count (2)
+    0x09, 0x30,       //     Usage (X)
+    0x09, 0x31,       //     Usage (Y)
+    0x81, 0x06,       //     Input (Data,Var,Rel)
+
+    // Wheel with its Resolution Multiplier
+    0xA1, 0x02,                   //     Collection (Logical)
+    0x09, 0x48,                   //       Usage (Resolution Multiplier)
+    0x15, 0x00,                   //       Logical Minimum (0)
+    0x25, 0x01,                   //       Logical Maximum (1)
+    0x35, 0x01,                   //       Physical Minimum (1)
+    0x45, WHEEL_MULTIPLIER,       //       Physical Maximum (counts per detent)
+    0x75, 0x02,                   //       Report Size (2)
+    0x95, 0x01,                   //       Report Count (1)
+    0xB1, 0x02,                   //       Feature (Data,Var,Abs)
+    0x75, 0x06,                   //       Report Size (6 bits padding)
+    0xB1, 0x03,                   //       Feature (Cnst,Var,Abs)
+    0x35, 0x00,                   //       Physical Minimum (0)
+    0x45, 0x00,                   //       Physical Maximum (0)
+    0x15, 0x81,                   //       Logical Minimum (-127)
+    0x25, 0x7F,                   //       Logical Maximum (127)
+    0x75, 0x08,                   //       Report Size (8)
+    0x09, 0x38,                   //       Usage (Wheel)
+    0x81, 0x06,                   //       Input (Data,Var,Rel)
+    0xC0,                         //     End Collection
+
+    // AC Pan
+    0x05, 0x0C,       //     Usage Page (Consumer)
+    0x0A, 0x38, 0x02, //     Usage (AC Pan)
+    0x15, 0x81,       //     Logical Minimum (-127)
+    0x25, 0x7F,       //     Logical Maximum (127)
+    0x75, 0x08,       //     Report Size (8)
+    0x95, 0x01,       //     Report Count (1)
+    0x81, 0x06,       //     Input (Data,Var,Rel)
+
+    0xC0, //   End Collection
+    0xC0, // End Collection
+};
 
-static enum usb_dc_status_code usb_status;
+// Resolution Multiplier feature byte as last set by the host. Hosts that
+// don't know about it leave it at 0 and get one wheel step per detent.
+static uint8_t wheel_feature;
+
+// Interface configured by the host, and the bus not suspended
+static bool iface_ready;
+static bool bus_suspended;
+
+// IN endpoint, double-buffered: one report is on the endpoint waiting for
+// the host's poll while the next one collects everything that comes in
+// meanwhile. The completion arms the collected one right away, so nothing
+// ever waits for the host and a host that stops polling only stops the
+// drain, not the mouse.
+static struct k_spinlock in_lock;
+UDC_STATIC_BUF_DEFINE(in_buf, USB_MOUSE_REPORT_SIZE); // on the endpoint, DMA-able
+static bool in_busy;
+static void *in_flight_latency; // for latency_tx_done()
+static struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t wheel;
+    uint8_t buttons; // current state, MOUSE_BTN_*
+    uint8_t pressed; // pressed since the last armed report, so short clicks survive
+    uint8_t sent_buttons;
+    bool has_sample;
+    uint32_t sample_cycles;
+    latency_stamps_t latency;
+} pending;
+
+static bool usb_in_kick(void);
 
 bool usb_hid_mouse_is_connected(void)
 {
-    return (usb_status == USB_DC_CONFIGURED);
+    return iface_ready && !bus_suspended;
 }
 
-void usb_hid_mouse_build_report(uint8_t *report,
-                                bool btn_left, bool btn_right, bool btn_middle,
-                                bool btn_forward, bool btn_back,
-                                int8_t dx, int8_t dy, int8_t wheel)
+#if defined(CONFIG_MOUSE_USB_POLL_STATS)
+static bool poll_chained;
+static uint32_t poll_last_cycles;
+static uint32_t poll_count;
+static uint32_t poll_min_us;
+static uint32_t poll_max_us;
+static uint64_t poll_sum_us;
+static uint64_t poll_sum_sq_us;
+
+// The host just read a report. If that report was armed by the previous
+// completion, the endpoint never ran dry and the gap between the two is
+// one host poll period.
+static void poll_stats_done(void)
 {
-    report[0] = (btn_left ? 1 << 0 : 0) |
-                (btn_right ? 1 << 1 : 0) |
-                (btn_middle ? 1 << 2 : 0) |
-                (btn_forward ? 1 << 3 : 0) |
-                (btn_back ? 1 << 4 : 0);
-    report[1] = dx;
-    report[2] = dy;
-    report[3] = wheel;
+    uint32_t now = k_cycle_get_32();
+    uint32_t interval_us = k_cyc_to_us_floor32(now - poll_last_cycles);
+    bool chained = poll_chained;
+
+    poll_last_cycles = now;
+    if (!chained)
+    {
+        return;
+    }
+
+    if (poll_count == 0)
+    {
+        poll_min_us = interval_us;
+        poll_max_us = interval_us;
+        poll_sum_us = 0;
+        poll_sum_sq_us = 0;
+    }
+    poll_min_us = MIN(poll_min_us, interval_us);
+    poll_max_us = MAX(poll_max_us, interval_us);
+    poll_sum_us += interval_us;
+    poll_sum_sq_us += (uint64_t)interval_us * interval_us;
+
+    if (++poll_count < CONFIG_MOUSE_USB_POLL_STATS_WINDOW)
+    {
+        return;
+    }
+
+    uint32_t mean_us = poll_sum_us / poll_count;
+    uint64_t variance = poll_sum_sq_us / poll_count - (uint64_t)mean_us * mean_us;
+    LOG_INF("IN polls: %u Hz, interval mean %u us, jitter (stddev) %u us, min %u us, max %u us over %u polls",
+            mean_us ? 1000000 / mean_us : 0, mean_us, (uint32_t)sqrtf((float)variance),
+            poll_min_us, poll_max_us, poll_count);
+    poll_count = 0;
 }
+#endif
 
-static void status_cb(enum usb_dc_status_code status, const uint8_t *param)
+static void iface_ready_cb(const struct device *dev, const bool ready)
 {
-    usb_status = status;
+    ARG_UNUSED(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    iface_ready = ready;
+    // A fresh configuration has nothing queued on the endpoint, whatever was
+    // there is gone with the old one
+    in_busy = false;
+    k_spin_unlock(&in_lock, key);
+
+    transport_link_changed(TRANSPORT_USB, usb_hid_mouse_is_connected());
+    usb_in_kick();
 }
 
-static void int_in_ready_cb(const struct device *dev)
+void usb_hid_mouse_suspended(bool suspended)
 {
-    ARG_UNUSED(dev);
-    k_sem_give(&ep_write_sem);
+    bus_suspended = suspended;
+    transport_link_changed(TRANSPORT_USB, usb_hid_mouse_is_connected());
+    usb_in_kick();
 }
 
-static const struct hid_ops ops = {
-    .int_in_ready = int_in_ready_cb,
-};
+void usb_hid_mouse_bus_reset(void)
+{
+    // The host sets the multiplier again when it enumerates us
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    wheel_feature = 0;
+    k_spin_unlock(&in_lock, key);
+}
 
-int usb_hid_mouse_init(void)
+// Start of every frame, from the USB device stack thread
+static void sof_cb(const struct device *dev)
 {
+    ARG_UNUSED(dev);
+    motion_sync_sof();
+}
 
-    int ret;
+// The host read the report on the endpoint, arm the next one straight away
+static void input_report_done_cb(const struct device *dev, const uint8_t *const report)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(report);
+    motion_sync_report_sent();
+    latency_tx_done(in_flight_latency);
+    in_flight_latency = NULL;
+    boot_timing_report_sent(TRANSPORT_USB);
+#if defined(CONFIG_MOUSE_USB_POLL_STATS)
+    poll_stats_done();
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    in_busy = false;
+    k_spin_unlock(&in_lock, key);
 
-#if defined(CONFIG_USB_DEVICE_STACK_NEXT)
-    hid_dev = DEVICE_DT_GET_ONE(zephyr_hid_device);
+    bool armed = usb_in_kick();
+#if defined(CONFIG_MOUSE_USB_POLL_STATS)
+    poll_chained = armed;
 #else
-    hid_dev = device_get_binding("HID_0");
+    ARG_UNUSED(armed);
 #endif
+}
+
+static int get_report_cb(const struct device *dev, const uint8_t type, const uint8_t id,
+                         const uint16_t len, uint8_t *const buf)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(id);
+
+    if (type != HID_REPORT_TYPE_FEATURE || len < sizeof(wheel_feature))
+    {
+        return -ENOTSUP;
+    }
+    buf[0] = wheel_feature;
+    return sizeof(wheel_feature);
+}
+
+static int set_report_cb(const struct device *dev, const uint8_t type, const uint8_t id,
+                         const uint16_t len, const uint8_t *const buf)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(id);
+
+    if (type != HID_REPORT_TYPE_FEATURE || len < sizeof(wheel_feature))
+    {
+        return -ENOTSUP;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    wheel_feature = buf[0] & 0x03;
+    k_spin_unlock(&in_lock, key);
+
+    LOG_INF("Hi-res wheel %s", wheel_feature ? "on" : "off");
+    return 0;
+}
 
-    if (!hid_dev)
+// With input_report_done set, hid_device_submit_report() only queues the
+// transfer and returns
+static const struct hid_device_ops ops = {
+    .iface_ready = iface_ready_cb,
+    .get_report = get_report_cb,
+    .set_report = set_report_cb,
+    .input_report_done = input_report_done_cb,
+    .sof = sof_cb,
+};
+
+static int usb_send_report(const mouse_report_t *report);
+
+static bool usb_is_ready(void)
+{
+    return usb_hid_mouse_is_connected();
+}
+
+static report_format_t usb_max_report_format(void)
+{
+    return REPORT_FORMAT_16BIT;
+}
+
+static const transport_t usb_transport = {
+    .name = "usb",
+    .send_report = usb_send_report,
+    .is_ready = usb_is_ready,
+    .max_report_format = usb_max_report_format,
+};
+
+int usb_hid_mouse_init(void)
+{
+    int ret;
+
+    if (!device_is_ready(hid_dev))
     {
-        LOG_ERR("Failed to get HID device");
+        LOG_ERR("HID device not ready");
         return 0;
     }
 
-    usb_hid_register_device(hid_dev,
-                            hid_report_desc, sizeof(hid_report_desc), &ops);
-    usb_hid_init(hid_dev);
+    transport_register(TRANSPORT_USB, &usb_transport);
 
-#if defined(CONFIG_USB_DEVICE_STACK_NEXT)
-    extern int enable_usb_device_next(void);
-    ret = enable_usb_device_next();
-#else
-    ret = usb_enable(status_cb);
-#endif
+    // The polling interval is the node's in-polling-period-us
+    ret = hid_device_register(hid_dev, hid_report_desc, sizeof(hid_report_desc), &ops);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed to register HID device: %d", ret);
+        return 0;
+    }
 
+    // Enumeration carries on in the USB device stack thread, iface_ready_cb()
+    // brings the transport up once the host has configured us
+    ret = usb_stack_init();
     if (ret != 0)
     {
         LOG_ERR("USB enable failed: %d", ret);
         return 0;
     }
 
-    k_sleep(K_SECONDS(2)); // Allow USB enumeration
-
     return 0;
 }
 
-static void build_report(uint8_t *report,
-                         bool btn_left, bool btn_right, bool btn_middle,
-                         bool btn_forward, bool btn_back,
-                         int8_t dx, int8_t dy, int8_t wheel)
+static void build_report(uint8_t *report, uint8_t buttons, int16_t dx, int16_t dy,
+                         int8_t wheel, int8_t pan)
 {
-    report[0] = (btn_left ? 1 << 0 : 0) |
-                (btn_right ? 1 << 1 : 0) |
-                (btn_middle ? 1 << 2 : 0) |
-                (btn_forward ? 1 << 3 : 0) |
-                (btn_back ? 1 << 4 : 0);
-    report[1] = dx;
-    report[2] = dy;
-    report[3] = wheel;
+    // USB has always sent forward as button 4 and back as button 5, the
+    // other way round from MOUSE_BTN_* (and BLE)
+    report[0] = (buttons & (MOUSE_BTN_LEFT | MOUSE_BTN_RIGHT | MOUSE_BTN_MIDDLE)) |
+                ((buttons & MOUSE_BTN_FORWARD) ? BIT(3) : 0) |
+                ((buttons & MOUSE_BTN_BACK) ? BIT(4) : 0);
+    sys_put_le16(dx, &report[1]);
+    sys_put_le16(dy, &report[3]);
+    report[5] = wheel;
+    report[6] = pan;
 }
 
-void usb_hid_mouse_update(bool left, bool right, bool middle, bool forward, bool back,
-                          int8_t dx, int8_t dy, int8_t wheel)
+// Encoder counts per wheel step on the wire: every count once the host has
+// switched the multiplier on, whole detents otherwise
+static int32_t wheel_divisor(void)
 {
-    if (!hid_dev)
-    {
-        LOG_ERR("HID device not initialized");
-        return;
-    }
+    return wheel_feature ? 1 : WHEEL_MULTIPLIER;
+}
+
+// Same rule as report_sched: anything to move, or buttons the host hasn't
+// seen. Equal deltas in a row are real motion and go out each time.
+static bool pending_has_data(void)
+{
+    return pending.x != 0 || pending.y != 0 || abs(pending.wheel) >= wheel_divisor() ||
+           pending.pressed != 0 || pending.buttons != pending.sent_buttons;
+}
 
+// Put the pending report on the endpoint if it is free. Called from the tx
+// stage and from the endpoint completion. Returns whether a report was armed.
+static bool usb_in_kick(void)
+{
     uint8_t report[USB_MOUSE_REPORT_SIZE];
-    build_report(report, left, right, middle, forward, back, dx, dy, wheel);
+    latency_stamps_t latency;
+    uint32_t sample_cycles;
+    bool has_sample;
+
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    if (in_busy || !usb_hid_mouse_is_connected() || !pending_has_data())
+    {
+        k_spin_unlock(&in_lock, key);
+        return false;
+    }
 
-    // Only send if report changed
-    if (memcmp(report, last_report, USB_MOUSE_REPORT_SIZE) == 0)
+    // What doesn't fit stays pending for the next poll, and so do wheel
+    // counts short of a whole detent while the host scrolls in detents
+    uint8_t pressed = pending.pressed;
+    uint8_t last_sent = pending.sent_buttons;
+    uint8_t buttons = pending.buttons | pressed;
+    int16_t dx = CLAMP(pending.x, -INT16_MAX, INT16_MAX);
+    int16_t dy = CLAMP(pending.y, -INT16_MAX, INT16_MAX);
+    int32_t divisor = wheel_divisor();
+    int8_t wheel = CLAMP(pending.wheel / divisor, -INT8_MAX, INT8_MAX);
+    pending.x -= dx;
+    pending.y -= dy;
+    pending.wheel -= wheel * divisor;
+    pending.pressed = 0;
+    pending.sent_buttons = buttons;
+
+    has_sample = pending.has_sample;
+    sample_cycles = pending.sample_cycles;
+    latency = pending.latency;
+    if (pending.x == 0 && pending.y == 0)
     {
-        return; // No change, skip
+        pending.has_sample = false;
+        pending.latency.origin = 0;
     }
 
-    memcpy(last_report, report, USB_MOUSE_REPORT_SIZE); // Update stored report
+    // No tilt wheel on this mouse, AC Pan stays 0
+    build_report(report, buttons, dx, dy, wheel, 0);
+
+    memcpy(in_buf, report, USB_MOUSE_REPORT_SIZE);
+    in_busy = true;
+    k_spin_unlock(&in_lock, key);
 
-    // print report in 1 line
-    // Decode button states into a readable string
-    char btns[6]; // 5 buttons + null terminator
-    snprintf(btns, sizeof(btns), "%c%c%c%c%c",
-             left ? 'L' : '-',
-             right ? 'R' : '-',
-             middle ? 'M' : '-',
-             forward ? 'F' : '-',
-             back ? 'B' : '-');
+    TRACE(TRACE_EV_USB_REPORT, in_buf[0], dx, dy, wheel);
+    motion_sync_report_queued(has_sample, sample_cycles);
+    in_flight_latency = latency_tx_start(&latency);
 
-    LOG_INF("Mouse report: btns=%s dx=%d dy=%d wheel=%d", btns, dx, dy, wheel);
+    int ret = hid_device_submit_report(hid_dev, USB_MOUSE_REPORT_SIZE, in_buf);
+    if (ret != 0)
+    {
+        in_flight_latency = NULL;
+        key = k_spin_lock(&in_lock);
+        in_busy = false;
+        // The host never got it: put it back under whatever came in since,
+        // so the next poll carries it
+        pending.x += dx;
+        pending.y += dy;
+        pending.wheel += wheel * divisor;
+        pending.pressed |= pressed;
+        if (pending.sent_buttons == buttons)
+        {
+            pending.sent_buttons = last_sent;
+        }
+        if (has_sample)
+        {
+            if (pending.latency.origin == 0)
+            {
+                pending.latency = latency;
+            }
+            if (!pending.has_sample)
+            {
+                pending.sample_cycles = sample_cycles;
+            }
+            pending.has_sample = true;
+        }
+        k_spin_unlock(&in_lock, key);
+        LOG_ERR("Failed to submit HID report: %d", ret);
+        return false;
+    }
+    return true;
+}
 
-    int ret = hid_int_ep_write(hid_dev, report, USB_MOUSE_REPORT_SIZE, NULL);
-    if (ret == 0)
+// Merge the report into the pending one and return, never waits for the host
+static int usb_send_report(const mouse_report_t *mouse)
+{
+    if (!device_is_ready(hid_dev))
     {
-        k_sem_take(&ep_write_sem, K_FOREVER);
+        LOG_ERR("HID device not ready");
+        return -ENODEV;
     }
-    else
+
+    k_spinlock_key_t key = k_spin_lock(&in_lock);
+    pending.x += mouse->x;
+    pending.y += mouse->y;
+    pending.wheel += mouse->wheel;
+    pending.pressed |= mouse->buttons & ~pending.buttons;
+    pending.buttons = mouse->buttons;
+    if (mouse->has_sample)
     {
-        LOG_ERR("Failed to write HID report: %d", ret);
+        // Age follows the newest sample, latency the oldest
+        if (!pending.has_sample || pending.latency.origin == 0)
+        {
+            pending.latency = mouse->latency;
+        }
+        pending.has_sample = true;
+        pending.sample_cycles = mouse->sample_cycles;
     }
+    k_spin_unlock(&in_lock, key);
+
+    usb_in_kick();
+    return 0;
+}
+
+void usb_hid_mouse_update(bool left, bool right, bool middle, bool forward, bool back,
+                          int8_t dx, int8_t dy, int8_t wheel)
+{
+    mouse_report_t report = {
+        .x = dx,
+        .y = dy,
+        .wheel = wheel,
+        .buttons = (left ? MOUSE_BTN_LEFT : 0) |
+                   (right ? MOUSE_BTN_RIGHT : 0) |
+                   (middle ? MOUSE_BTN_MIDDLE : 0) |
+                   (forward ? MOUSE_BTN_FORWARD : 0) |
+                   (back ? MOUSE_BTN_BACK : 0),
+    };
+
+    usb_send_report(&report);
 }
 
 void usb_hid_mouse_test(void)
@@ -4,7 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define USB_MOUSE_REPORT_SIZE 4
+#define USB_MOUSE_REPORT_SIZE 7
 
 #ifdef __cplusplus
 extern "C"
@@ -17,6 +17,10 @@ extern "C"
                               int8_t dx, int8_t dy, int8_t wheel);
     bool usb_hid_mouse_is_connected(void);
 
+    // Bus events from the USB device stack's message callback
+    void usb_hid_mouse_suspended(bool suspended);
+    void usb_hid_mouse_bus_reset(void);
+
     void usb_hid_mouse_test(void);
 
 #ifdef __cplusplus
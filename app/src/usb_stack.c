@@ -0,0 +1,118 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/usb/usbd.h>
+#include <zephyr/logging/log.h>
+
+#include "usb_stack.h"
+#include "usb_hid.h"
+
+LOG_MODULE_REGISTER(usb_stack, LOG_LEVEL_INF);
+
+USBD_DEVICE_DEFINE(mouse_usbd, DEVICE_DT_GET(DT_NODELABEL(zephyr_udc0)),
+                   CONFIG_MOUSE_USB_VID, CONFIG_MOUSE_USB_PID);
+
+USBD_DESC_LANG_DEFINE(mouse_lang);
+USBD_DESC_MANUFACTURER_DEFINE(mouse_mfr, CONFIG_MOUSE_USB_MANUFACTURER);
+USBD_DESC_PRODUCT_DEFINE(mouse_product, CONFIG_MOUSE_USB_PRODUCT);
+USBD_DESC_CONFIG_DEFINE(fs_cfg_desc, "FS Configuration");
+
+// Bus powered, 100 mA (bMaxPower is in 2 mA units)
+USBD_CONFIGURATION_DEFINE(fs_config, 0, 50, &fs_cfg_desc);
+
+// Runs in the USB device stack thread
+static void msg_cb(struct usbd_context *const ctx, const struct usbd_msg *const msg)
+{
+    switch (msg->type)
+    {
+    case USBD_MSG_VBUS_READY:
+        if (usbd_enable(ctx) != 0)
+        {
+            LOG_ERR("Failed to enable USB device");
+        }
+        break;
+    case USBD_MSG_VBUS_REMOVED:
+        usbd_disable(ctx);
+        break;
+    case USBD_MSG_SUSPEND:
+        usb_hid_mouse_suspended(true);
+        break;
+    case USBD_MSG_RESUME:
+        usb_hid_mouse_suspended(false);
+        break;
+    case USBD_MSG_RESET:
+        usb_hid_mouse_bus_reset();
+        break;
+    case USBD_MSG_UDC_ERROR:
+    case USBD_MSG_STACK_ERROR:
+        LOG_ERR("USB error %d", msg->status);
+        break;
+    default:
+        break;
+    }
+}
+
+int usb_stack_init(void)
+{
+    int err;
+
+    err = usbd_add_descriptor(&mouse_usbd, &mouse_lang);
+    if (err == 0)
+    {
+        err = usbd_add_descriptor(&mouse_usbd, &mouse_mfr);
+    }
+    if (err == 0)
+    {
+        err = usbd_add_descriptor(&mouse_usbd, &mouse_product);
+    }
+    if (err != 0)
+    {
+        LOG_ERR("Failed to add USB string descriptors: %d", err);
+        return err;
+    }
+
+    err = usbd_add_configuration(&mouse_usbd, USBD_SPEED_FS, &fs_config);
+    if (err != 0)
+    {
+        LOG_ERR("Failed to add USB configuration: %d", err);
+        return err;
+    }
+
+    err = usbd_register_all_classes(&mouse_usbd, USBD_SPEED_FS, 1, NULL);
+    if (err != 0)
+    {
+        LOG_ERR("Failed to register USB classes: %d", err);
+        return err;
+    }
+
+    // CDC ACM next to the HID needs an interface association descriptor
+    if (IS_ENABLED(CONFIG_USBD_CDC_ACM_CLASS))
+    {
+        usbd_device_set_code_triple(&mouse_usbd, USBD_SPEED_FS, USB_BCC_MISCELLANEOUS, 0x02, 0x01);
+    }
+
+    err = usbd_msg_register_cb(&mouse_usbd, msg_cb);
+    if (err != 0)
+    {
+        LOG_ERR("Failed to register USB message callback: %d", err);
+        return err;
+    }
+
+    err = usbd_init(&mouse_usbd);
+    if (err != 0)
+    {
+        LOG_ERR("Failed to initialize USB device: %d", err);
+        return err;
+    }
+
+    // With VBUS detection the stack is enabled on USBD_MSG_VBUS_READY
+    if (!usbd_can_detect_vbus(&mouse_usbd))
+    {
+        err = usbd_enable(&mouse_usbd);
+        if (err != 0)
+        {
+            LOG_ERR("Failed to enable USB device: %d", err);
+        }
+    }
+
+    return err;
+}
@@ -0,0 +1,19 @@
+#ifndef USB_STACK_H
+#define USB_STACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Bring up the device_next USB device: descriptors, one full-speed
+    // configuration with every class instance in devicetree (the mouse HID
+    // and the CDC ACM console), then enable it, right away or once VBUS is
+    // there. Class instances must be registered with their class first.
+    int usb_stack_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USB_STACK_H
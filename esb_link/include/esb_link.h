@@ -0,0 +1,130 @@
+#ifndef ESB_LINK_H_
+#define ESB_LINK_H_
+
+/**
+ * @file esb_link.h
+ *
+ * @brief Mouse report link over Enhanced ShockBurst
+ *
+ * The mouse is the PTX and sends one packet per report; the receiver is the
+ * PRX and answers each packet in hardware with an ACK that carries its own
+ * small payload (host state). Reports are deltas, so the PTX hands a report
+ * that ran out of retransmits back to the caller, which merges it into the
+ * next one instead of dropping counts.
+ *
+ * Both ends walk the same hop table: the PTX moves on after
+ * CONFIG_ESB_LINK_HOP_FAILURES failed packets in a row, the PRX after
+ * CONFIG_ESB_LINK_PRX_DWELL_MS without hearing anything. A keepalive keeps
+ * the PRX on the channel while the mouse is still.
+ */
+
+#include <zephyr/kernel.h>
+#include "esb_radio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESB_LINK_ACK_PAYLOAD_MAX 8
+
+// Byte 0 of the receiver's ACK payload
+#define ESB_LINK_ACK_HOST_READY BIT(0) // USB configured, reports get through
+
+struct esb_link_report {
+    int16_t x;
+    int16_t y;
+    int8_t wheel;
+    uint8_t buttons; // left, right, middle, back, forward from bit 0
+} __packed;
+
+struct esb_link_stats {
+    uint32_t tx_ok;
+    uint32_t tx_failed;
+    uint32_t tx_attempts; // transmissions including retransmits
+    uint32_t hops;
+    uint32_t rx;
+    uint32_t rx_dup;
+};
+
+struct esb_link;
+
+struct esb_link_callbacks {
+    // PRX: a new report arrived (radio ISR context)
+    void (*report)(struct esb_link *link, const struct esb_link_report *report);
+    // PTX: payload the PRX sent back with an ACK (radio ISR context)
+    void (*ack_payload)(struct esb_link *link, const uint8_t *data, size_t len);
+    // PTX: the PRX started or stopped answering
+    void (*link_state)(struct esb_link *link, bool up);
+};
+
+struct esb_link {
+    struct esb_radio *radio;
+    enum esb_radio_role role;
+    const struct esb_link_callbacks *cb;
+    void *user_data;
+
+    uint8_t hop_idx;
+    uint8_t seq;
+    bool up;
+    struct esb_link_stats stats;
+
+    // PTX
+    struct k_mutex tx_lock;
+    struct k_sem tx_done;
+    bool tx_ok;
+    atomic_t tx_busy; // a frame is with the radio and has not reported back
+    uint8_t fail_streak;
+    uint8_t sweep_failures;
+    struct k_work_delayable keepalive;
+    struct esb_radio_frame held; // report sent but not ACKed, resent as is
+    bool held_valid;
+
+    // PRX
+    int16_t last_seq;
+    uint8_t ack[ESB_LINK_ACK_PAYLOAD_MAX];
+    uint8_t ack_len;
+    struct k_work_delayable dwell;
+};
+
+/**
+ * @brief Bring up one end of the link
+ *
+ * @param link Link instance
+ * @param radio Radio backend, not yet initialised
+ * @param role ESB_RADIO_PTX on the mouse, ESB_RADIO_PRX on the receiver
+ * @param cb Callbacks, may leave members NULL
+ * @param user_data Kept in link->user_data
+ */
+int esb_link_init(struct esb_link *link, struct esb_radio *radio, enum esb_radio_role role,
+                  const struct esb_link_callbacks *cb, void *user_data);
+
+/**
+ * @brief Send one report and wait for its ACK (PTX)
+ *
+ * A report that went on air without an ACK may still have reached the PRX.
+ * The link keeps it and sends it again, with its sequence number, ahead of
+ * the next report or keepalive, so the PRX applies it at most once.
+ *
+ * @retval 0 ACKed
+ * @retval -EINPROGRESS Sent but not ACKed (retransmits exhausted or no radio
+ *         result within @p timeout). The link owns the deltas now.
+ * @retval -EAGAIN Not sent: an earlier unACKed report still didn't get
+ *         through, or the link was busy. The caller still owns the deltas.
+ * @retval <0 Other radio errors, not sent either
+ */
+int esb_link_send_report(struct esb_link *link, const struct esb_link_report *report,
+                         k_timeout_t timeout);
+
+/** @brief Payload to attach to the following ACKs (PRX) */
+int esb_link_set_ack_payload(struct esb_link *link, const uint8_t *data, size_t len);
+
+/** @brief Whether the other end answered recently */
+bool esb_link_is_up(const struct esb_link *link);
+
+void esb_link_get_stats(const struct esb_link *link, struct esb_link_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESB_LINK_H_ */
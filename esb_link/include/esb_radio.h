@@ -0,0 +1,131 @@
+#ifndef ESB_RADIO_H_
+#define ESB_RADIO_H_
+
+/**
+ * @file esb_radio.h
+ *
+ * @brief Radio backend used by esb_link
+ *
+ * Models what the link needs from Enhanced ShockBurst: a PTX sends a frame
+ * and the radio retransmits it until it is ACKed or the budget runs out; a
+ * PRX receives frames and answers with the ACK payload queued for the
+ * pipe. Backends: the nRF RADIO through the ESB library, and an in-process
+ * simulated PHY.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESB_RADIO_MAX_PAYLOAD 32
+#define ESB_RADIO_ADDR_LEN 5
+
+enum esb_radio_role {
+    ESB_RADIO_PTX,
+    ESB_RADIO_PRX,
+};
+
+enum esb_radio_event_type {
+    ESB_RADIO_EVT_TX_SUCCESS, // PTX: frame ACKed, PRX: ACK payload sent
+    ESB_RADIO_EVT_TX_FAILED,  // PTX: retransmit budget exhausted
+    ESB_RADIO_EVT_RX,         // PTX: ACK payload, PRX: new frame
+};
+
+struct esb_radio_frame {
+    uint8_t pipe;
+    uint8_t len;
+    int8_t rssi;
+    uint8_t data[ESB_RADIO_MAX_PAYLOAD];
+};
+
+struct esb_radio_event {
+    enum esb_radio_event_type type;
+    uint8_t attempts;                    // TX events: transmissions used
+    const struct esb_radio_frame *frame; // RX events
+};
+
+struct esb_radio;
+
+// Called from the radio interrupt (or the simulated equivalent)
+typedef void (*esb_radio_event_cb_t)(struct esb_radio *radio, const struct esb_radio_event *evt);
+
+struct esb_radio_config {
+    enum esb_radio_role role;
+    uint8_t retransmits;
+    uint16_t retransmit_delay_us;
+    uint8_t channel;
+    uint8_t address[ESB_RADIO_ADDR_LEN];
+};
+
+struct esb_radio_api {
+    int (*init)(struct esb_radio *radio, const struct esb_radio_config *cfg);
+    // Only while no frame is in flight
+    int (*set_channel)(struct esb_radio *radio, uint8_t channel);
+    // PTX: send a frame. PRX: queue the payload for the next ACK.
+    int (*write)(struct esb_radio *radio, const struct esb_radio_frame *frame);
+    // PRX: start listening
+    int (*start_rx)(struct esb_radio *radio);
+};
+
+struct esb_radio {
+    const struct esb_radio_api *api;
+    void *ctx; // backend state
+    esb_radio_event_cb_t cb;
+    void *user_data;
+};
+
+static inline int esb_radio_init(struct esb_radio *radio, const struct esb_radio_config *cfg,
+                                 esb_radio_event_cb_t cb, void *user_data)
+{
+    radio->cb = cb;
+    radio->user_data = user_data;
+    return radio->api->init(radio, cfg);
+}
+
+static inline int esb_radio_set_channel(struct esb_radio *radio, uint8_t channel)
+{
+    return radio->api->set_channel(radio, channel);
+}
+
+static inline int esb_radio_write(struct esb_radio *radio, const struct esb_radio_frame *frame)
+{
+    return radio->api->write(radio, frame);
+}
+
+static inline int esb_radio_start_rx(struct esb_radio *radio)
+{
+    return radio->api->start_rx(radio);
+}
+
+#if defined(CONFIG_ESB_LINK_RADIO_NRF)
+/** @brief The nRF RADIO. There is one, so there is one instance. */
+struct esb_radio *esb_radio_nrf_get(void);
+#endif
+
+#if defined(CONFIG_ESB_LINK_RADIO_SIM)
+/**
+ * @brief Two ends of one simulated link.
+ *
+ * Frames only get through when both ends are on the same channel. Loss is
+ * the per-channel drop rate if set, else the global one, applied to each
+ * transmission and to each ACK independently.
+ */
+void esb_radio_sim_get_pair(struct esb_radio **ptx, struct esb_radio **prx);
+
+/** @brief Drop rate in percent for all channels without their own rate. */
+void esb_radio_sim_set_drop(uint8_t percent);
+
+/** @brief Drop rate in percent on one channel, e.g. to model interference. */
+void esb_radio_sim_set_channel_drop(uint8_t channel, uint8_t percent);
+
+/** @brief Transmissions put on the air so far, retransmits included. */
+uint32_t esb_radio_sim_air_count(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESB_RADIO_H_ */
@@ -0,0 +1,337 @@
+/*
+ * Mouse report link over Enhanced ShockBurst
+ *
+ * One packet per report, ACKed by the receiver in hardware. The PTX hops
+ * after a few failed packets in a row and the PRX after a quiet dwell, so
+ * both ends end up on the first channel of the hop table that gets through.
+ */
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+#include "esb_link.h"
+
+LOG_MODULE_REGISTER(esb_link, LOG_LEVEL_INF);
+
+#define ESB_LINK_PKT_REPORT    0x01
+#define ESB_LINK_PKT_KEEPALIVE 0x02
+#define ESB_LINK_HDR_LEN       2 // type, sequence
+
+// Longest a PTX packet can hold the radio before the radio reports back
+#define ESB_LINK_TX_TIMEOUT \
+    K_USEC((CONFIG_ESB_LINK_RETRANSMITS + 1) * CONFIG_ESB_LINK_RETRANSMIT_DELAY_US + 1000)
+
+// 2400 + n MHz. Spread over the band and clear of the centres of Wi-Fi
+// channels 1, 6 and 11 (2412, 2437, 2462 MHz).
+static const uint8_t hop_table[] = {4, 24, 49, 75, 80};
+
+static uint8_t esb_link_channel(const struct esb_link *link) {
+    return hop_table[link->hop_idx];
+}
+
+static void esb_link_hop(struct esb_link *link) {
+    link->hop_idx = (link->hop_idx + 1) % ARRAY_SIZE(hop_table);
+    link->stats.hops++;
+    esb_radio_set_channel(link->radio, esb_link_channel(link));
+}
+
+static void esb_link_set_up(struct esb_link *link, bool up) {
+    if (link->up == up) {
+        return;
+    }
+    link->up = up;
+    if (link->cb && link->cb->link_state) {
+        link->cb->link_state(link, up);
+    }
+}
+
+static void esb_link_ptx_event(struct esb_link *link, const struct esb_radio_event *evt) {
+    switch (evt->type) {
+    case ESB_RADIO_EVT_TX_SUCCESS:
+        link->stats.tx_ok++;
+        link->stats.tx_attempts += evt->attempts;
+        link->fail_streak = 0;
+        link->sweep_failures = 0;
+        link->tx_ok = true;
+        esb_link_set_up(link, true);
+        atomic_clear(&link->tx_busy);
+        k_sem_give(&link->tx_done);
+        break;
+    case ESB_RADIO_EVT_TX_FAILED:
+        link->stats.tx_failed++;
+        link->stats.tx_attempts += evt->attempts;
+        link->tx_ok = false;
+        if (++link->fail_streak >= CONFIG_ESB_LINK_HOP_FAILURES) {
+            link->fail_streak = 0;
+            esb_link_hop(link);
+            // A whole sweep without an ACK: the receiver is gone
+            if (++link->sweep_failures >= ARRAY_SIZE(hop_table)) {
+                link->sweep_failures = 0;
+                esb_link_set_up(link, false);
+            }
+        }
+        atomic_clear(&link->tx_busy);
+        k_sem_give(&link->tx_done);
+        break;
+    case ESB_RADIO_EVT_RX:
+        if (link->cb && link->cb->ack_payload && evt->frame->len > 0) {
+            link->cb->ack_payload(link, evt->frame->data, evt->frame->len);
+        }
+        break;
+    }
+}
+
+static void esb_link_prx_event(struct esb_link *link, const struct esb_radio_event *evt) {
+    const struct esb_radio_frame *frame = evt->frame;
+
+    switch (evt->type) {
+    case ESB_RADIO_EVT_TX_SUCCESS:
+        // The ACK took the payload with it, queue it again for the next one
+        if (link->ack_len > 0) {
+            esb_link_set_ack_payload(link, link->ack, link->ack_len);
+        }
+        break;
+    case ESB_RADIO_EVT_TX_FAILED:
+        break;
+    case ESB_RADIO_EVT_RX:
+        if (frame->len < ESB_LINK_HDR_LEN) {
+            break;
+        }
+        k_work_reschedule(&link->dwell, K_MSEC(CONFIG_ESB_LINK_PRX_DWELL_MS));
+        esb_link_set_up(link, true);
+
+        // The radio drops retransmits it has already ACKed on this channel,
+        // this also catches the ones the PTX repeats after a hop
+        if (frame->data[1] == link->last_seq) {
+            link->stats.rx_dup++;
+            break;
+        }
+        link->last_seq = frame->data[1];
+        link->stats.rx++;
+
+        if (frame->data[0] == ESB_LINK_PKT_REPORT &&
+            frame->len >= ESB_LINK_HDR_LEN + sizeof(struct esb_link_report) && link->cb &&
+            link->cb->report) {
+            struct esb_link_report report;
+
+            memcpy(&report, &frame->data[ESB_LINK_HDR_LEN], sizeof(report));
+            report.x = sys_le16_to_cpu(report.x);
+            report.y = sys_le16_to_cpu(report.y);
+            link->cb->report(link, &report);
+        }
+        break;
+    }
+}
+
+static void esb_link_radio_event(struct esb_radio *radio, const struct esb_radio_event *evt) {
+    struct esb_link *link = radio->user_data;
+
+    if (link->role == ESB_RADIO_PTX) {
+        esb_link_ptx_event(link, evt);
+    } else {
+        esb_link_prx_event(link, evt);
+    }
+}
+
+// Caller holds tx_lock. -EBUSY: not written, the radio still has the
+// previous frame. -EAGAIN: written, no result within the timeout.
+static int esb_link_write_frame(struct esb_link *link, const struct esb_radio_frame *frame,
+                                k_timeout_t timeout) {
+    int err;
+
+    // A frame that timed out can still be on air. Its result has to come
+    // in first, or it would be taken for the result of this one.
+    if (atomic_get(&link->tx_busy) && k_sem_take(&link->tx_done, timeout)) {
+        return -EBUSY;
+    }
+
+    k_sem_reset(&link->tx_done);
+    atomic_set(&link->tx_busy, 1);
+    err = esb_radio_write(link->radio, frame);
+    if (err) {
+        atomic_clear(&link->tx_busy);
+        return err;
+    }
+    if (k_sem_take(&link->tx_done, timeout)) {
+        return -EAGAIN;
+    }
+    return link->tx_ok ? 0 : -EIO;
+}
+
+// Caller holds tx_lock. A report the PRX may or may not have got goes out
+// again, with the same sequence number, before anything else does: the PRX
+// only drops a repeat of the last sequence it saw.
+static int esb_link_resend_held(struct esb_link *link, k_timeout_t timeout) {
+    int err;
+
+    if (!link->held_valid) {
+        return 0;
+    }
+    err = esb_link_write_frame(link, &link->held, timeout);
+    if (err == 0) {
+        link->held_valid = false;
+    }
+    return err;
+}
+
+// Caller holds tx_lock
+static int esb_link_transmit(struct esb_link *link, uint8_t type, const void *body, size_t len,
+                             k_timeout_t timeout) {
+    struct esb_radio_frame frame = {
+        .pipe = 0,
+        .len = ESB_LINK_HDR_LEN + len,
+    };
+    int err;
+
+    frame.data[0] = type;
+    frame.data[1] = ++link->seq;
+    if (len > 0) {
+        memcpy(&frame.data[ESB_LINK_HDR_LEN], body, len);
+    }
+
+    err = esb_link_write_frame(link, &frame, timeout);
+    if (err == -EBUSY) {
+        // Never reached the radio, nothing to hold
+        return -EAGAIN;
+    }
+    if ((err == -EIO || err == -EAGAIN) && type == ESB_LINK_PKT_REPORT) {
+        // On air but not ACKed: it may have arrived with only the ACK lost
+        link->held = frame;
+        link->held_valid = true;
+        return -EINPROGRESS;
+    }
+    return err;
+}
+
+static void esb_link_keepalive(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct esb_link *link = CONTAINER_OF(dwork, struct esb_link, keepalive);
+
+    // A report in flight does the job already. A held report keeps the
+    // channel alive in place of the keepalive, which would move the
+    // sequence on under it.
+    if (k_mutex_lock(&link->tx_lock, K_NO_WAIT) == 0) {
+        if (link->held_valid) {
+            esb_link_resend_held(link, ESB_LINK_TX_TIMEOUT);
+        } else {
+            esb_link_transmit(link, ESB_LINK_PKT_KEEPALIVE, NULL, 0, ESB_LINK_TX_TIMEOUT);
+        }
+        k_mutex_unlock(&link->tx_lock);
+    }
+    k_work_schedule(dwork, K_MSEC(CONFIG_ESB_LINK_KEEPALIVE_MS));
+}
+
+static void esb_link_dwell_expired(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct esb_link *link = CONTAINER_OF(dwork, struct esb_link, dwell);
+
+    esb_link_set_up(link, false);
+    esb_link_hop(link);
+    k_work_schedule(dwork, K_MSEC(CONFIG_ESB_LINK_PRX_DWELL_MS));
+}
+
+int esb_link_init(struct esb_link *link, struct esb_radio *radio, enum esb_radio_role role,
+                  const struct esb_link_callbacks *cb, void *user_data) {
+    struct esb_radio_config cfg = {
+        .role = role,
+        .retransmits = CONFIG_ESB_LINK_RETRANSMITS,
+        .retransmit_delay_us = CONFIG_ESB_LINK_RETRANSMIT_DELAY_US,
+        .channel = hop_table[0],
+    };
+    int err;
+
+    sys_put_le32(CONFIG_ESB_LINK_BASE_ADDRESS, cfg.address);
+    cfg.address[4] = CONFIG_ESB_LINK_PREFIX;
+
+    memset(link, 0, sizeof(*link));
+    link->radio = radio;
+    link->role = role;
+    link->cb = cb;
+    link->user_data = user_data;
+    link->last_seq = -1;
+    k_mutex_init(&link->tx_lock);
+    k_sem_init(&link->tx_done, 0, 1);
+    k_work_init_delayable(&link->keepalive, esb_link_keepalive);
+    k_work_init_delayable(&link->dwell, esb_link_dwell_expired);
+
+    err = esb_radio_init(radio, &cfg, esb_link_radio_event, link);
+    if (err) {
+        LOG_ERR("Radio init failed: %d", err);
+        return err;
+    }
+
+    if (role == ESB_RADIO_PRX) {
+        err = esb_radio_start_rx(radio);
+        if (err) {
+            LOG_ERR("Can't start RX: %d", err);
+            return err;
+        }
+        k_work_schedule(&link->dwell, K_MSEC(CONFIG_ESB_LINK_PRX_DWELL_MS));
+    } else {
+        k_work_schedule(&link->keepalive, K_NO_WAIT);
+    }
+
+    LOG_INF("%s up on %u MHz", role == ESB_RADIO_PTX ? "PTX" : "PRX",
+            2400 + esb_link_channel(link));
+    return 0;
+}
+
+int esb_link_send_report(struct esb_link *link, const struct esb_link_report *report,
+                         k_timeout_t timeout) {
+    struct esb_link_report wire = *report;
+    int err;
+
+    if (link->role != ESB_RADIO_PTX) {
+        return -ENOTSUP;
+    }
+
+    wire.x = sys_cpu_to_le16(report->x);
+    wire.y = sys_cpu_to_le16(report->y);
+
+    err = k_mutex_lock(&link->tx_lock, timeout);
+    if (err) {
+        return -EAGAIN;
+    }
+    err = esb_link_resend_held(link, timeout);
+    if (err == 0) {
+        err = esb_link_transmit(link, ESB_LINK_PKT_REPORT, &wire, sizeof(wire), timeout);
+    } else {
+        // This one never went out
+        err = -EAGAIN;
+    }
+    k_mutex_unlock(&link->tx_lock);
+
+    // Reports keep the PRX on the channel, only fill the gaps
+    k_work_reschedule(&link->keepalive, K_MSEC(CONFIG_ESB_LINK_KEEPALIVE_MS));
+    return err;
+}
+
+int esb_link_set_ack_payload(struct esb_link *link, const uint8_t *data, size_t len) {
+    struct esb_radio_frame frame = {
+        .pipe = 0,
+        .len = len,
+    };
+
+    if (link->role != ESB_RADIO_PRX) {
+        return -ENOTSUP;
+    }
+    if (len > ESB_LINK_ACK_PAYLOAD_MAX) {
+        return -EINVAL;
+    }
+
+    if (data != link->ack) {
+        memcpy(link->ack, data, len);
+        link->ack_len = len;
+    }
+    memcpy(frame.data, data, len);
+    return esb_radio_write(link->radio, &frame);
+}
+
+bool esb_link_is_up(const struct esb_link *link) {
+    return link->up;
+}
+
+void esb_link_get_stats(const struct esb_link *link, struct esb_link_stats *stats) {
+    *stats = link->stats;
+}
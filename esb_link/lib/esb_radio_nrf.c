@@ -0,0 +1,174 @@
+/*
+ * nRF RADIO through the nRF Connect SDK ESB library
+ *
+ * ESB takes the RADIO and its interrupt for itself, so this backend can't
+ * run next to the Bluetooth controller.
+ */
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/clock_control.h>
+#include <zephyr/drivers/clock_control/nrf_clock_control.h>
+#include <zephyr/logging/log.h>
+#include <esb.h>
+#include <errno.h>
+#include <string.h>
+#include "esb_radio.h"
+
+LOG_MODULE_REGISTER(esb_radio_nrf, LOG_LEVEL_INF);
+
+static struct esb_radio nrf_radio;
+static enum esb_radio_role nrf_role;
+
+// ESB needs the crystal for its timing, the RC oscillator is off spec
+static int nrf_hfclk_start(void) {
+    struct onoff_manager *mgr = z_nrf_clock_control_get_onoff(CLOCK_CONTROL_NRF_SUBSYS_HF);
+    struct onoff_client cli;
+    int res;
+    int err;
+
+    if (!mgr) {
+        return -ENXIO;
+    }
+
+    sys_notify_init_spinwait(&cli.notify);
+    err = onoff_request(mgr, &cli);
+    if (err < 0) {
+        return err;
+    }
+
+    do {
+        err = sys_notify_fetch_result(&cli.notify, &res);
+    } while (err == -EAGAIN);
+
+    return err ? err : res;
+}
+
+static void nrf_emit(enum esb_radio_event_type type, uint8_t attempts,
+                     const struct esb_radio_frame *frame) {
+    const struct esb_radio_event evt = {
+        .type = type,
+        .attempts = attempts,
+        .frame = frame,
+    };
+
+    if (nrf_radio.cb) {
+        nrf_radio.cb(&nrf_radio, &evt);
+    }
+}
+
+static void nrf_event_handler(const struct esb_evt *event) {
+    struct esb_payload payload;
+    struct esb_radio_frame frame;
+
+    switch (event->evt_id) {
+    case ESB_EVENT_TX_SUCCESS:
+        nrf_emit(ESB_RADIO_EVT_TX_SUCCESS, event->tx_attempts, NULL);
+        break;
+    case ESB_EVENT_TX_FAILED:
+        // Drop the frame rather than let the next write queue behind it
+        esb_flush_tx();
+        nrf_emit(ESB_RADIO_EVT_TX_FAILED, event->tx_attempts, NULL);
+        break;
+    case ESB_EVENT_RX_RECEIVED:
+        while (esb_read_rx_payload(&payload) == 0) {
+            frame.pipe = payload.pipe;
+            frame.len = MIN(payload.length, ESB_RADIO_MAX_PAYLOAD);
+            frame.rssi = payload.rssi;
+            memcpy(frame.data, payload.data, frame.len);
+            nrf_emit(ESB_RADIO_EVT_RX, 0, &frame);
+        }
+        break;
+    }
+}
+
+static int nrf_init(struct esb_radio *radio, const struct esb_radio_config *cfg) {
+    struct esb_config config = ESB_DEFAULT_CONFIG;
+    int err;
+
+    err = nrf_hfclk_start();
+    if (err) {
+        LOG_ERR("HF clock start failed: %d", err);
+        return err;
+    }
+
+    nrf_role = cfg->role;
+    config.protocol = ESB_PROTOCOL_ESB_DPL;
+    config.mode = cfg->role == ESB_RADIO_PTX ? ESB_MODE_PTX : ESB_MODE_PRX;
+    config.bitrate = ESB_BITRATE_2MBPS;
+    config.event_handler = nrf_event_handler;
+    config.retransmit_delay = cfg->retransmit_delay_us;
+    config.retransmit_count = cfg->retransmits;
+    config.tx_mode = ESB_TXMODE_AUTO;
+    config.selective_auto_ack = false;
+    config.use_fast_ramp_up = true;
+
+    err = esb_init(&config);
+    if (err) {
+        return err;
+    }
+
+    err = esb_set_base_address_0(cfg->address);
+    if (err) {
+        return err;
+    }
+
+    err = esb_set_prefixes(&cfg->address[4], 1);
+    if (err) {
+        return err;
+    }
+
+    return esb_set_rf_channel(cfg->channel);
+}
+
+static int nrf_set_channel(struct esb_radio *radio, uint8_t channel) {
+    int err;
+
+    if (nrf_role == ESB_RADIO_PTX) {
+        return esb_set_rf_channel(channel);
+    }
+
+    // The PRX has to be idle to retune
+    esb_stop_rx();
+    err = esb_set_rf_channel(channel);
+    if (err == 0) {
+        err = esb_start_rx();
+    }
+    return err;
+}
+
+static int nrf_write(struct esb_radio *radio, const struct esb_radio_frame *frame) {
+    struct esb_payload payload = {
+        .pipe = frame->pipe,
+        .length = frame->len,
+        .noack = false,
+    };
+
+    if (frame->len > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
+        return -EINVAL;
+    }
+    memcpy(payload.data, frame->data, frame->len);
+
+    // An ACK payload replaces whatever was still queued for the pipe
+    if (nrf_role == ESB_RADIO_PRX) {
+        esb_flush_tx();
+    }
+    return esb_write_payload(&payload);
+}
+
+static int nrf_start_rx(struct esb_radio *radio) {
+    return esb_start_rx();
+}
+
+static const struct esb_radio_api nrf_api = {
+    .init = nrf_init,
+    .set_channel = nrf_set_channel,
+    .write = nrf_write,
+    .start_rx = nrf_start_rx,
+};
+
+static struct esb_radio nrf_radio = {
+    .api = &nrf_api,
+};
+
+struct esb_radio *esb_radio_nrf_get(void) {
+    return &nrf_radio;
+}
@@ -0,0 +1,245 @@
+/*
+ * Simulated ESB radio
+ *
+ * A PTX and a PRX sharing one medium. Each transmission takes its airtime
+ * at 2 Mbps, only reaches the PRX when both are on the same channel, and
+ * is lost with the drop rate of that channel; so is the ACK. Retransmits,
+ * the PID duplicate filter and ACK payloads behave like the nRF ESB
+ * library, closely enough to exercise the link layer and its hopping.
+ */
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <string.h>
+#include "esb_radio.h"
+
+#define SIM_CHANNELS     101
+#define SIM_DROP_DEFAULT 0xFF // channel follows the global drop rate
+#define SIM_RAMP_US      40   // fast ramp-up
+#define SIM_ACK_TURN_US  60   // PRX turnaround plus ACK airtime
+// Preamble, address, packet control field and CRC around the payload
+#define SIM_OVERHEAD_BYTES 10
+#define SIM_US_PER_BYTE    4
+
+struct sim_end {
+    struct esb_radio radio;
+    struct esb_radio_config cfg;
+    uint8_t channel;
+    bool rx_on;
+};
+
+struct sim_medium {
+    struct k_spinlock lock;
+    struct k_timer timer;
+    struct sim_end ptx;
+    struct sim_end prx;
+
+    // PTX frame in flight
+    struct esb_radio_frame tx;
+    bool tx_busy;
+    uint8_t attempts;
+    uint8_t pid;
+
+    // PRX side
+    struct esb_radio_frame ack;
+    bool ack_pending;
+    int16_t last_pid;
+
+    uint8_t drop_global;
+    uint8_t drop[SIM_CHANNELS];
+    uint32_t rng;
+    uint32_t air_count;
+};
+
+static struct sim_medium medium;
+
+static struct sim_end *sim_end_of(struct esb_radio *radio) {
+    return CONTAINER_OF(radio, struct sim_end, radio);
+}
+
+static uint32_t sim_rand(void) {
+    // xorshift32, deterministic so runs can be compared
+    uint32_t x = medium.rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    medium.rng = x;
+    return x;
+}
+
+static bool sim_lost(uint8_t channel) {
+    uint8_t pct = medium.drop[channel] == SIM_DROP_DEFAULT ? medium.drop_global
+                                                            : medium.drop[channel];
+
+    return pct > 0 && (sim_rand() % 100) < pct;
+}
+
+static uint32_t sim_airtime_us(const struct esb_radio_frame *frame) {
+    return SIM_RAMP_US + (SIM_OVERHEAD_BYTES + frame->len) * SIM_US_PER_BYTE + SIM_ACK_TURN_US;
+}
+
+static void sim_emit(struct sim_end *end, enum esb_radio_event_type type, uint8_t attempts,
+                     const struct esb_radio_frame *frame) {
+    const struct esb_radio_event evt = {
+        .type = type,
+        .attempts = attempts,
+        .frame = frame,
+    };
+
+    if (end->radio.cb) {
+        end->radio.cb(&end->radio, &evt);
+    }
+}
+
+// One transmission of the PTX frame has finished, ACK window included
+static void sim_timer_expiry(struct k_timer *timer) {
+    struct esb_radio_frame rx, ack;
+    bool deliver = false, acked = false, ack_payload = false, failed = false;
+    uint8_t attempts;
+
+    k_spinlock_key_t key = k_spin_lock(&medium.lock);
+    uint8_t channel = medium.ptx.channel;
+
+    medium.attempts++;
+    medium.air_count++;
+    attempts = medium.attempts;
+
+    if (medium.prx.rx_on && medium.prx.channel == channel && !sim_lost(channel)) {
+        // Retransmits of a packet the PRX already has are ACKed, not passed up
+        if (medium.pid != medium.last_pid) {
+            medium.last_pid = medium.pid;
+            rx = medium.tx;
+            rx.rssi = -50;
+            deliver = true;
+        }
+        acked = !sim_lost(channel);
+        if (acked && medium.ack_pending) {
+            ack = medium.ack;
+            medium.ack_pending = false;
+            ack_payload = true;
+        }
+    }
+
+    if (acked) {
+        medium.tx_busy = false;
+    } else if (medium.attempts > medium.ptx.cfg.retransmits) {
+        medium.tx_busy = false;
+        failed = true;
+    } else {
+        k_timer_start(&medium.timer, K_USEC(medium.ptx.cfg.retransmit_delay_us), K_NO_WAIT);
+    }
+    k_spin_unlock(&medium.lock, key);
+
+    if (deliver) {
+        sim_emit(&medium.prx, ESB_RADIO_EVT_RX, 0, &rx);
+    }
+    if (ack_payload) {
+        sim_emit(&medium.prx, ESB_RADIO_EVT_TX_SUCCESS, 1, NULL);
+        sim_emit(&medium.ptx, ESB_RADIO_EVT_RX, 0, &ack);
+    }
+    if (acked) {
+        sim_emit(&medium.ptx, ESB_RADIO_EVT_TX_SUCCESS, attempts, NULL);
+    } else if (failed) {
+        sim_emit(&medium.ptx, ESB_RADIO_EVT_TX_FAILED, attempts, NULL);
+    }
+}
+
+static int sim_init(struct esb_radio *radio, const struct esb_radio_config *cfg) {
+    struct sim_end *end = sim_end_of(radio);
+
+    end->cfg = *cfg;
+    end->channel = cfg->channel;
+    end->rx_on = false;
+    return 0;
+}
+
+static int sim_set_channel(struct esb_radio *radio, uint8_t channel) {
+    struct sim_end *end = sim_end_of(radio);
+
+    if (channel >= SIM_CHANNELS) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&medium.lock);
+    int err = (end == &medium.ptx && medium.tx_busy) ? -EBUSY : 0;
+
+    if (err == 0) {
+        end->channel = channel;
+    }
+    k_spin_unlock(&medium.lock, key);
+    return err;
+}
+
+static int sim_write(struct esb_radio *radio, const struct esb_radio_frame *frame) {
+    struct sim_end *end = sim_end_of(radio);
+    int err = 0;
+
+    if (frame->len > ESB_RADIO_MAX_PAYLOAD) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&medium.lock);
+
+    if (end == &medium.prx) {
+        medium.ack = *frame;
+        medium.ack_pending = true;
+    } else if (medium.tx_busy) {
+        err = -EBUSY;
+    } else {
+        medium.tx = *frame;
+        medium.tx_busy = true;
+        medium.attempts = 0;
+        medium.pid = (medium.pid + 1) & 0x03;
+        k_timer_start(&medium.timer, K_USEC(sim_airtime_us(frame)), K_NO_WAIT);
+    }
+    k_spin_unlock(&medium.lock, key);
+    return err;
+}
+
+static int sim_start_rx(struct esb_radio *radio) {
+    struct sim_end *end = sim_end_of(radio);
+
+    if (end != &medium.prx) {
+        return -ENOTSUP;
+    }
+    end->rx_on = true;
+    return 0;
+}
+
+static const struct esb_radio_api sim_api = {
+    .init = sim_init,
+    .set_channel = sim_set_channel,
+    .write = sim_write,
+    .start_rx = sim_start_rx,
+};
+
+static int sim_medium_init(void) {
+    medium.ptx.radio.api = &sim_api;
+    medium.prx.radio.api = &sim_api;
+    medium.last_pid = -1;
+    medium.rng = 0x2545F491;
+    memset(medium.drop, SIM_DROP_DEFAULT, sizeof(medium.drop));
+    k_timer_init(&medium.timer, sim_timer_expiry, NULL);
+    return 0;
+}
+
+SYS_INIT(sim_medium_init, PRE_KERNEL_2, 0);
+
+void esb_radio_sim_get_pair(struct esb_radio **ptx, struct esb_radio **prx) {
+    *ptx = &medium.ptx.radio;
+    *prx = &medium.prx.radio;
+}
+
+void esb_radio_sim_set_drop(uint8_t percent) {
+    medium.drop_global = MIN(percent, 100);
+}
+
+void esb_radio_sim_set_channel_drop(uint8_t channel, uint8_t percent) {
+    if (channel < SIM_CHANNELS) {
+        medium.drop[channel] = MIN(percent, 100);
+    }
+}
+
+uint32_t esb_radio_sim_air_count(void) {
+    return medium.air_count;
+}
@@ -0,0 +1,153 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <nsi_main.h>
+
+#include "esb_link.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
+
+#define BENCH_REPORTS 2000
+#define BENCH_INTERVAL_US 1000
+#define BENCH_TX_TIMEOUT K_MSEC(10)
+// Long enough for a keepalive to resend a report the link still holds
+#define BENCH_DRAIN_MS (CONFIG_ESB_LINK_KEEPALIVE_MS * 3)
+
+struct bench_run
+{
+    const char *name;
+    uint8_t drop_pct;
+    int8_t jam_channel; // channel dropping everything, -1 for none
+};
+
+static const struct bench_run runs[] = {
+    {"clean", 0, -1},
+    // Right after the clean run, while both ends still sit on the first channel
+    {"first channel jammed", 0, 4},
+    {"5% loss", 5, -1},
+    {"20% loss", 20, -1},
+    {"50% loss", 50, -1},
+};
+
+static struct esb_link ptx;
+static struct esb_link prx;
+
+static volatile uint32_t sent_cycles;
+static uint32_t latency_count;
+static uint64_t latency_sum_us;
+static uint32_t latency_max_us;
+static int32_t received_x;
+
+static void prx_report(struct esb_link *link, const struct esb_link_report *report)
+{
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - sent_cycles);
+
+    latency_count++;
+    latency_sum_us += us;
+    latency_max_us = MAX(latency_max_us, us);
+    received_x += report->x;
+}
+
+static const struct esb_link_callbacks prx_cb = {
+    .report = prx_report,
+};
+
+// Returns false if the PRX got fewer or more counts than were sent. More
+// means a report was applied twice.
+static bool bench(const struct bench_run *run)
+{
+    struct esb_link_stats ptx_before, ptx_after, prx_before, prx_after;
+    struct esb_link_report report = {0};
+    int32_t sent_x = 0;
+    int16_t pending_x = 0;
+
+    esb_radio_sim_set_drop(run->drop_pct);
+    if (run->jam_channel >= 0)
+    {
+        esb_radio_sim_set_channel_drop(run->jam_channel, 100);
+    }
+
+    latency_count = 0;
+    latency_sum_us = 0;
+    latency_max_us = 0;
+    received_x = 0;
+    esb_link_get_stats(&ptx, &ptx_before);
+    esb_link_get_stats(&prx, &prx_before);
+
+    for (int i = 0; i < BENCH_REPORTS; ++i)
+    {
+        // One count per report, plus whatever the last failed one carried
+        report.x = pending_x + 1;
+        sent_x++;
+
+        sent_cycles = k_cycle_get_32();
+        int err = esb_link_send_report(&ptx, &report, BENCH_TX_TIMEOUT);
+        // -EINPROGRESS: the link resends it itself
+        pending_x = (err && err != -EINPROGRESS) ? report.x : 0;
+        k_usleep(BENCH_INTERVAL_US);
+    }
+
+    esb_link_get_stats(&ptx, &ptx_after);
+    esb_link_get_stats(&prx, &prx_after);
+    esb_radio_sim_set_drop(0);
+    if (run->jam_channel >= 0)
+    {
+        esb_radio_sim_set_channel_drop(run->jam_channel, 0);
+    }
+
+    // Flush what is still owed on a clean channel, then every count sent
+    // must have arrived exactly once
+    for (int tries = 0; pending_x != 0 && tries < 10; ++tries)
+    {
+        report.x = pending_x;
+        int err = esb_link_send_report(&ptx, &report, BENCH_TX_TIMEOUT);
+        pending_x = (err && err != -EINPROGRESS) ? report.x : 0;
+    }
+    k_msleep(BENCH_DRAIN_MS);
+
+    uint32_t ok = ptx_after.tx_ok - ptx_before.tx_ok;
+    uint32_t failed = ptx_after.tx_failed - ptx_before.tx_failed;
+    uint32_t attempts = ptx_after.tx_attempts - ptx_before.tx_attempts;
+
+    LOG_INF("%s: %u ok, %u failed, %u.%02u tx/report, latency mean %u us max %u us, "
+            "%u PTX hops, %u PRX hops, x sent %d received %d (%d in flight)",
+            run->name, ok, failed, attempts / MAX(ok + failed, 1),
+            (attempts * 100 / MAX(ok + failed, 1)) % 100,
+            latency_count ? (uint32_t)(latency_sum_us / latency_count) : 0, latency_max_us,
+            ptx_after.hops - ptx_before.hops, prx_after.hops - prx_before.hops, sent_x,
+            received_x, pending_x);
+
+    if (received_x != sent_x)
+    {
+        LOG_ERR("%s: FAIL, %d counts %s", run->name, received_x - sent_x,
+                received_x > sent_x ? "applied twice" : "lost");
+        return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    struct esb_radio *ptx_radio, *prx_radio;
+
+    esb_radio_sim_get_pair(&ptx_radio, &prx_radio);
+    if (esb_link_init(&prx, prx_radio, ESB_RADIO_PRX, &prx_cb, NULL) ||
+        esb_link_init(&ptx, ptx_radio, ESB_RADIO_PTX, NULL, NULL))
+    {
+        LOG_ERR("Link init failed");
+        return 0;
+    }
+
+    // Let the keepalive find the receiver
+    k_msleep(50);
+
+    bool ok = true;
+    for (int i = 0; i < ARRAY_SIZE(runs); ++i)
+    {
+        ok &= bench(&runs[i]);
+    }
+
+    LOG_INF("%s", ok ? "PASS" : "FAIL");
+    nsi_exit(ok ? 0 : 1);
+    return 0;
+}
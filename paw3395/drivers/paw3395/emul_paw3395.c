@@ -0,0 +1,329 @@
+/*
+ * PAW3395 SPI emulator
+ *
+ * Models enough of the sensor to run the driver on native_sim:
+ * - Banked register file (0x7F selects the bank), product ID
+ * - Power-up reset and the 0x6C init handshake
+ * - 12-byte motion burst, cleared by reading it
+ * - Motion pin, asserted while motion is latched
+ * - Scriptable motion playback
+ */
+#define DT_DRV_COMPAT pixart_paw3395
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/drivers/gpio.h>
+#ifdef CONFIG_GPIO_EMUL
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#endif
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include "paw3395.h"
+#include "paw3395_emul.h"
+
+LOG_MODULE_REGISTER(paw3395_emul);
+
+#define EMUL_SPI_WRITE_BIT 0x80
+#define EMUL_BANK_COUNT 0x20
+#define EMUL_REG_COUNT 0x80
+#define EMUL_XFER_MAX 32
+
+#define EMUL_REG_PRODUCT_ID 0x00
+#define EMUL_REG_MOTION 0x02
+#define EMUL_REG_MOTION_BURST 0x16
+#define EMUL_REG_POWER_UP_RESET 0x3A
+#define EMUL_REG_INV_PRODUCT_ID 0x5F
+#define EMUL_REG_INIT_STATUS 0x6C
+#define EMUL_REG_BANK 0x7F
+
+#define EMUL_PRODUCT_ID 0x51
+#define EMUL_POWER_UP_RESET_VAL 0x5A
+#define EMUL_INIT_STATUS_DONE 0x80
+#define EMUL_DEFAULT_SQUAL 0x30
+#define EMUL_DEFAULT_HANDSHAKE_READS 3
+
+struct paw3395_emul_cfg {
+    struct gpio_dt_spec irq_gpio;
+};
+
+struct paw3395_emul_data {
+    const struct emul *target;
+    struct k_spinlock lock;
+    uint8_t regs[EMUL_BANK_COUNT][EMUL_REG_COUNT];
+    uint8_t bank;
+    uint8_t pending_addr; // read address sent in an earlier transfer
+    bool pending_valid;
+    uint32_t handshake_reads;
+    uint32_t init_status_reads;
+    // latched motion, cleared by a burst
+    int32_t dx;
+    int32_t dy;
+    uint8_t squal;
+    bool motion;
+    struct paw3395_emul_stats stats;
+    // motion script playback
+    struct k_work_delayable play_work;
+    const struct paw3395_emul_motion *script;
+    size_t script_len;
+    size_t script_pos;
+    int64_t script_start_us;
+};
+
+static void paw3395_emul_set_irq(const struct emul *target, bool active) {
+#ifdef CONFIG_GPIO_EMUL
+    const struct paw3395_emul_cfg *cfg = target->cfg;
+
+    if (cfg->irq_gpio.port == NULL) return;
+    int level = (cfg->irq_gpio.dt_flags & GPIO_ACTIVE_LOW) ? !active : active;
+    gpio_emul_input_set(cfg->irq_gpio.port, cfg->irq_gpio.pin, level);
+#else
+    ARG_UNUSED(target);
+    ARG_UNUSED(active);
+#endif
+}
+
+static void paw3395_emul_power_up_reset(struct paw3395_emul_data *data) {
+    memset(data->regs, 0, sizeof(data->regs));
+    data->bank = 0;
+    data->regs[0][EMUL_REG_PRODUCT_ID] = EMUL_PRODUCT_ID;
+    data->regs[0][EMUL_REG_INV_PRODUCT_ID] = (uint8_t)~EMUL_PRODUCT_ID;
+    data->init_status_reads = 0;
+    data->pending_valid = false;
+    data->dx = 0;
+    data->dy = 0;
+    data->motion = false;
+}
+
+static void paw3395_emul_write(struct paw3395_emul_data *data, uint8_t reg, uint8_t val) {
+    data->stats.writes++;
+    if (reg == EMUL_REG_BANK) {
+        data->bank = val % EMUL_BANK_COUNT;
+        return;
+    }
+    if (data->bank == 0 && reg == EMUL_REG_POWER_UP_RESET && val == EMUL_POWER_UP_RESET_VAL) {
+        paw3395_emul_power_up_reset(data);
+        return;
+    }
+    data->regs[data->bank][reg] = val;
+}
+
+static void paw3395_emul_burst(struct paw3395_emul_data *data, uint8_t *out, size_t len) {
+    uint8_t burst[12] = {0};
+    int16_t dx = CLAMP(data->dx, INT16_MIN, INT16_MAX);
+    int16_t dy = CLAMP(data->dy, INT16_MIN, INT16_MAX);
+
+    data->stats.bursts++;
+    burst[0] = data->motion ? PAW3395_MOTION_MOT : 0;
+    sys_put_le16(dx, &burst[2]);
+    sys_put_le16(dy, &burst[4]);
+    burst[6] = data->squal;
+    burst[7] = data->squal / 2; // raw data sum, plausible next to SQUAL
+    burst[8] = 0x80;
+    burst[9] = 0x10;
+    sys_put_be16(0x0100, &burst[10]);
+    memcpy(out, burst, MIN(len, sizeof(burst)));
+
+    data->dx -= dx;
+    data->dy -= dy;
+    data->motion = data->dx != 0 || data->dy != 0;
+}
+
+static uint8_t paw3395_emul_read(struct paw3395_emul_data *data, uint8_t reg) {
+    data->stats.reads++;
+    if (reg == EMUL_REG_BANK) return data->bank;
+    if (data->bank == 0 && reg == EMUL_REG_INIT_STATUS &&
+        data->regs[0][EMUL_REG_INIT_STATUS] != EMUL_INIT_STATUS_DONE) {
+        if (data->init_status_reads < data->handshake_reads) {
+            data->init_status_reads++;
+            return 0x00;
+        }
+        data->regs[0][EMUL_REG_INIT_STATUS] = EMUL_INIT_STATUS_DONE;
+    }
+    if (data->bank == 0 && reg == EMUL_REG_MOTION) {
+        return data->motion ? PAW3395_MOTION_MOT : 0;
+    }
+    return data->regs[data->bank][reg];
+}
+
+// Data phase of a read, out[0] is the first byte after the address
+static void paw3395_emul_read_data(struct paw3395_emul_data *data, uint8_t reg, uint8_t *out,
+                                   size_t len) {
+    if (len == 0) return;
+    if (reg == EMUL_REG_MOTION_BURST && data->bank == 0) {
+        paw3395_emul_burst(data, out, len);
+    } else {
+        out[0] = paw3395_emul_read(data, reg);
+    }
+}
+
+static size_t paw3395_emul_buf_set_len(const struct spi_buf_set *set) {
+    size_t len = 0;
+
+    for (size_t i = 0; set != NULL && i < set->count; ++i) {
+        len += set->buffers[i].len;
+    }
+    return len;
+}
+
+static int paw3395_emul_io(const struct emul *target, const struct spi_config *config,
+                           const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs) {
+    struct paw3395_emul_data *data = target->data;
+    uint8_t tx[EMUL_XFER_MAX] = {0};
+    uint8_t rx[EMUL_XFER_MAX] = {0};
+    size_t tx_len = paw3395_emul_buf_set_len(tx_bufs);
+    size_t rx_len = paw3395_emul_buf_set_len(rx_bufs);
+    size_t len = MAX(tx_len, rx_len);
+    size_t pos = 0;
+
+    ARG_UNUSED(config);
+    if (len > sizeof(tx)) return -EINVAL;
+
+    for (size_t i = 0; tx_bufs != NULL && i < tx_bufs->count; ++i) {
+        const struct spi_buf *buf = &tx_bufs->buffers[i];
+        if (buf->buf != NULL) memcpy(&tx[pos], buf->buf, buf->len);
+        pos += buf->len;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    bool had_motion = data->motion;
+    if (tx_len == 0) {
+        // Address went out in an earlier transfer with NCS held
+        if (data->pending_valid) {
+            paw3395_emul_read_data(data, data->pending_addr, rx, rx_len);
+            data->pending_valid = false;
+        }
+    } else if (tx[0] & EMUL_SPI_WRITE_BIT) {
+        // One or more back-to-back (address, value) pairs
+        for (pos = 0; pos + 1 < tx_len; pos += 2) {
+            paw3395_emul_write(data, tx[pos] & ~EMUL_SPI_WRITE_BIT, tx[pos + 1]);
+        }
+    } else if (len > 1) {
+        paw3395_emul_read_data(data, tx[0], &rx[1], len - 1);
+    } else {
+        data->pending_addr = tx[0];
+        data->pending_valid = true;
+    }
+    bool release_irq = had_motion && !data->motion;
+    k_spin_unlock(&data->lock, key);
+
+    pos = 0;
+    for (size_t i = 0; rx_bufs != NULL && i < rx_bufs->count; ++i) {
+        const struct spi_buf *buf = &rx_bufs->buffers[i];
+        if (buf->buf != NULL) memcpy(buf->buf, &rx[pos], buf->len);
+        pos += buf->len;
+    }
+
+    if (release_irq) paw3395_emul_set_irq(target, false);
+    return 0;
+}
+
+void paw3395_emul_add_motion(const struct emul *target, int16_t dx, int16_t dy, uint8_t squal) {
+    struct paw3395_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    data->dx += dx;
+    data->dy += dy;
+    data->squal = squal;
+    data->motion = data->dx != 0 || data->dy != 0;
+    bool assert_irq = data->motion;
+    k_spin_unlock(&data->lock, key);
+
+    if (assert_irq) paw3395_emul_set_irq(target, true);
+}
+
+static void paw3395_emul_play_work(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct paw3395_emul_data *data = CONTAINER_OF(dwork, struct paw3395_emul_data, play_work);
+    const struct paw3395_emul_motion *step;
+
+    // Run every step that is due, then sleep until the next one
+    while (data->script_pos < data->script_len) {
+        step = &data->script[data->script_pos];
+        int64_t due_us = data->script_start_us + step->t_us;
+        if (due_us > k_ticks_to_us_floor64(k_uptime_ticks())) {
+            k_work_schedule(dwork, K_TIMEOUT_ABS_US(due_us));
+            return;
+        }
+        paw3395_emul_add_motion(data->target, step->dx, step->dy, step->squal);
+        data->script_pos++;
+    }
+}
+
+void paw3395_emul_play(const struct emul *target, const struct paw3395_emul_motion *script,
+                       size_t len) {
+    struct paw3395_emul_data *data = target->data;
+
+    k_work_cancel_delayable(&data->play_work);
+    data->script = script;
+    data->script_len = len;
+    data->script_pos = 0;
+    data->script_start_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    k_work_schedule(&data->play_work, K_NO_WAIT);
+}
+
+bool paw3395_emul_is_playing(const struct emul *target) {
+    struct paw3395_emul_data *data = target->data;
+    return data->script_pos < data->script_len;
+}
+
+void paw3395_emul_set_handshake_reads(const struct emul *target, uint32_t reads) {
+    struct paw3395_emul_data *data = target->data;
+    data->handshake_reads = reads;
+}
+
+uint8_t paw3395_emul_get_reg(const struct emul *target, uint8_t bank, uint8_t reg) {
+    struct paw3395_emul_data *data = target->data;
+    return data->regs[bank % EMUL_BANK_COUNT][reg % EMUL_REG_COUNT];
+}
+
+void paw3395_emul_get_stats(const struct emul *target, struct paw3395_emul_stats *stats) {
+    struct paw3395_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    *stats = data->stats;
+    k_spin_unlock(&data->lock, key);
+}
+
+void paw3395_emul_reset_stats(const struct emul *target) {
+    struct paw3395_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    memset(&data->stats, 0, sizeof(data->stats));
+    k_spin_unlock(&data->lock, key);
+}
+
+static int paw3395_emul_init(const struct emul *target, const struct device *parent) {
+    struct paw3395_emul_data *data = target->data;
+
+    ARG_UNUSED(parent);
+    data->target = target;
+    data->handshake_reads = EMUL_DEFAULT_HANDSHAKE_READS;
+    data->squal = EMUL_DEFAULT_SQUAL;
+    paw3395_emul_power_up_reset(data);
+    k_work_init_delayable(&data->play_work, paw3395_emul_play_work);
+    return 0;
+}
+
+static const struct spi_emul_api paw3395_emul_api = {
+    .io = paw3395_emul_io,
+};
+
+#define PAW3395_EMUL_DEFINE(inst)                                            \
+    static const struct paw3395_emul_cfg paw3395_emul_cfg_##inst = {        \
+        .irq_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, irq_gpios, {0}),         \
+    };                                                                       \
+                                                                             \
+    static struct paw3395_emul_data paw3395_emul_data_##inst;                \
+                                                                             \
+    EMUL_DT_INST_DEFINE(inst,                                                \
+                        paw3395_emul_init,                                   \
+                        &paw3395_emul_data_##inst,                           \
+                        &paw3395_emul_cfg_##inst,                            \
+                        &paw3395_emul_api,                                   \
+                        NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(PAW3395_EMUL_DEFINE)
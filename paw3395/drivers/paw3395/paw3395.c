@@ -5,8 +5,11 @@
  * - CPI (DPI) configuration (800, 1600, 2400, 3200, 5000, 10000, 26000)
  * - Power saving: Rest1=30s, Rest2=400s, Rest3=5000s
  * - Lift cutoff configurable
+ * - Run mode switching (HP, LP, Office, Game)
  * - Zephyr sensor API glue: sample_fetch, channel_get, attr_set, trigger_set
  * - Motion burst read
+ * - Shadow copy of configuration registers, redundant writes and bank switches skipped
+ * - Optional RTIO read path (sensor_read / streaming) on top of async SPI
  * - No LED or unrelated peripheral code
  */
 #define DT_DRV_COMPAT pixart_paw3395
@@ -19,6 +22,10 @@
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/devicetree.h>
+#include <string.h>
+#ifdef CONFIG_PAW3395_ASYNC
+#include <zephyr/rtio/rtio.h>
+#endif
 #include "paw3395.h"
 #include "pixart.h"
 #include "paw3395_priv.h"
@@ -39,20 +46,56 @@ LOG_MODULE_REGISTER(paw3395);
 #define PAW3395_REG_REST1_DOWNSHIFT 0x79
 #define PAW3395_REG_REST2_DOWNSHIFT 0x7B
 #define PAW3395_REG_REST3_DOWNSHIFT 0x7C
+#define PAW3395_REG_BANK_SELECT 0x7F
 #define PAW3395_PRODUCT_ID 0x51
-#define SPI_WRITE_BIT 0x80
-#define PAW3395_BURST_SIZE 6
+#define PAW3395_BURST_SIZE 12
+// Motion burst layout
 #define PAW3395_MOTION 0 // motion byte
+#define PAW3395_OBSERVATION_POS 1
 #define PAW3395_DX_POS 2 // dx byte
-#define PAW3395_DY_POS 4 // dx byte
+#define PAW3395_DY_POS 4 // dy byte
+#define PAW3395_SQUAL_POS 6
+#define PAW3395_RAW_DATA_SUM_POS 7
+#define PAW3395_RAW_DATA_MAX_POS 8
+#define PAW3395_RAW_DATA_MIN_POS 9
+#define PAW3395_SHUTTER_POS 10 // upper byte first
 
 #define CPI_TO_REG(cpi) (((cpi) / 50) - 1)
 
+// 0x7F value after a failed bank switch, forces the next one out
+#define PAW3395_BANK_UNKNOWN 0xFF
+// Largest group paw3395_update_regs() sends in one transfer
+#define PAW3395_MAX_REG_WRITES 6
+
+// SPI timing (us), PAW3395 datasheet
+#define PAW3395_T_SRAD_US 2  // address to data, read and motion burst
+#define PAW3395_T_SWW_US 5   // write to next write
+#define PAW3395_T_SWR_US 5   // write to next read
+#define PAW3395_T_SRW_US 2   // read to next command
+
+// Time from VDD up to the first SPI access
+#define PAW3395_POWER_UP_MS 50
+
+// Power-up runs from init_work, these are its async_init_step values
+enum paw3395_init_step {
+    PAW3395_INIT_STEP_SCRIPT,
+    PAW3395_INIT_STEP_CONFIGURE,
+    PAW3395_INIT_STEP_DONE,
+};
+
 // Power saving times (ms)
 #define PAW3395_REST1_DOWNSHIFT_MS 30000
 #define PAW3395_REST2_DOWNSHIFT_MS 400000
 #define PAW3395_REST3_DOWNSHIFT_MS 5000000
 
+static const struct pixart_spi_timing paw3395_spi_timing = {
+    .t_srad = PAW3395_T_SRAD_US,
+    .t_srad_burst = PAW3395_T_SRAD_US,
+    .t_sww = PAW3395_T_SWW_US,
+    .t_swr = PAW3395_T_SWR_US,
+    .t_srw = PAW3395_T_SRW_US,
+};
+
 static const uint32_t paw3395_cpi_choices[] = {
     800, 1600, 2400, 3200, 5000, 10000, 26000
 };
@@ -60,40 +103,99 @@ static const uint32_t paw3395_cpi_choices[] = {
 // In pixart.h or paw3395.h
 #define paw3395_config pixart_config
 
+// Buffer handed back through the RTIO read path, decoded by paw3395_decoder
+struct paw3395_encoded_data {
+    uint64_t timestamp; // ns
+    uint32_t cycles;    // same instant, for paw3395_motion_frame
+    uint32_t irq_cycles; // latest motion IRQ
+    uint8_t burst[PAW3395_BURST_SIZE];
+};
+
 struct paw3395_data {
     struct pixart_data base;
-    int16_t x;
-    int16_t y;
+    struct paw3395_motion_frame frame; // last burst with motion
     bool ready;
+    struct paw3395_script_state script; // power-up progress
+    enum paw3395_run_mode run_mode;     // power-up table leaves HP mode
+    uint32_t init_start;                // cycles, for the init time log
+    uint32_t irq_cycles;                // cycles at the latest motion IRQ
+    uint8_t bank;                       // last value written to 0x7F
+    // Bank 0 configuration registers as last written or read, see
+    // paw3395_reg_cacheable()
+    uint8_t shadow[0x80];
+    uint32_t shadow_valid[0x80 / 32];
+#ifdef CONFIG_PAW3395_ASYNC
+    struct rtio_iodev_sqe *pending_sqe; // read in flight
+    struct rtio_iodev_sqe *stream_sqe;  // waiting for the next motion IRQ
+#endif
 };
 
-static int paw3395_spi_write(const struct device *dev, uint8_t reg, uint8_t val) {
-    const struct pixart_config *cfg = dev->config;
-    uint8_t buf[2] = {reg | SPI_WRITE_BIT, val};
-    struct spi_buf tx_buf = {.buf = buf, .len = 2};
-    struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1};
-    return spi_write_dt(&cfg->bus, &tx);
+static int paw3395_update_regs(const struct device *dev, const struct pixart_reg_write *writes,
+                               size_t count, const struct pixart_reg_write *commit);
+
+// Bank 0 registers that only change when we write them. Status, motion and
+// command registers such as SET_RESOLUTION always go to the bus.
+static bool paw3395_reg_cacheable(uint8_t reg) {
+    switch (reg) {
+        case PAW3395_REG_LIFT_CONFIG_H:
+        case PAW3395_REG_RESOLUTION_X_LOW:
+        case PAW3395_REG_RESOLUTION_X_HIGH:
+        case PAW3395_REG_RESOLUTION_Y_LOW:
+        case PAW3395_REG_RESOLUTION_Y_HIGH:
+        case PAW3395_REG_LIFT_CONFIG_L:
+        case PAW3395_REG_RUN_DOWNSHIFT:
+        case 0x78: // REST1_PERIOD
+        case PAW3395_REG_REST1_DOWNSHIFT:
+        case 0x7A: // REST2_PERIOD
+        case PAW3395_REG_REST2_DOWNSHIFT:
+        case PAW3395_REG_REST3_DOWNSHIFT:
+            return true;
+        default:
+            return false;
+    }
 }
 
-static int paw3395_spi_read(const struct device *dev, uint8_t reg, uint8_t *val) {
-    const struct pixart_config *cfg = dev->config;
-    struct spi_buf tx_buf = {.buf = &reg, .len = 1};
-    struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1};
-    int err = spi_write_dt(&cfg->bus, &tx);
-    if (err) return err;
-    struct spi_buf rx_buf = {.buf = val, .len = 1};
-    struct spi_buf_set rx = {.buffers = &rx_buf, .count = 1};
-    return spi_read_dt(&cfg->bus, &rx);
+static bool paw3395_shadow_get(const struct paw3395_data *data, uint8_t reg, uint8_t *val) {
+    if (!(data->shadow_valid[reg / 32] & BIT(reg % 32))) return false;
+    *val = data->shadow[reg];
+    return true;
 }
 
-// paw3395 spi transcieve function - use spi_transceive_dt()
-static int paw3395_spi_transceive(const struct device *dev, const uint8_t *tx_buf, size_t tx_len, uint8_t *rx_buf, size_t rx_len) {
-    const struct pixart_config *cfg = dev->config;
-    struct spi_buf tx_spi_buf = { .buf = (void *)tx_buf, .len = tx_len };
-    struct spi_buf_set tx_set = { .buffers = &tx_spi_buf, .count = 1 };
-    struct spi_buf rx_spi_buf = { .buf = rx_buf, .len = rx_len };
-    struct spi_buf_set rx_set = { .buffers = &rx_spi_buf, .count = 1 };
-    return spi_transceive_dt(&cfg->bus, &tx_set, &rx_set);
+static void paw3395_shadow_set(struct paw3395_data *data, uint8_t reg, uint8_t val) {
+    if (data->bank != 0 || !paw3395_reg_cacheable(reg)) return;
+    data->shadow[reg] = val;
+    data->shadow_valid[reg / 32] |= BIT(reg % 32);
+}
+
+static void paw3395_shadow_invalidate(struct paw3395_data *data) {
+    memset(data->shadow_valid, 0, sizeof(data->shadow_valid));
+}
+
+// Read a bank 0 configuration register, from the shadow when we have it
+static int paw3395_read_config(const struct device *dev, uint8_t reg, uint8_t *val) {
+    struct paw3395_data *data = dev->data;
+    int err;
+
+    if (paw3395_shadow_get(data, reg, val)) return 0;
+    pixart_spi_begin(&data->base.spi);
+    err = 0;
+    if (data->bank != 0) {
+        err = pixart_spi_write(&data->base.spi, PAW3395_REG_BANK_SELECT, 0x00);
+        data->bank = err ? PAW3395_BANK_UNKNOWN : 0;
+    }
+    if (err == 0) {
+        err = pixart_spi_read(&data->base.spi, reg, val);
+    }
+    if (err == 0) {
+        paw3395_shadow_set(data, reg, *val);
+    }
+    pixart_spi_end(&data->base.spi);
+    return err;
+}
+
+static int paw3395_write_config(const struct device *dev, uint8_t reg, uint8_t val) {
+    const struct pixart_reg_write write = {reg, val};
+    return paw3395_update_regs(dev, &write, 1, NULL);
 }
 
 // Set the rest period for a given rest mode (1, 2, or 3)
@@ -121,7 +223,7 @@ static int paw3395_set_rest_period(const struct device *dev, uint8_t rest_mode,
         default:
             return -EINVAL;
     }
-    return paw3395_spi_write(dev, reg, val);
+    return paw3395_write_config(dev, reg, val);
 }
 
 // Get the rest period (in ms) for a given rest mode (1, 2, or 3)
@@ -133,19 +235,19 @@ static int paw3395_get_rest_period(const struct device *dev, uint8_t rest_mode,
     switch (rest_mode) {
         case 1:
             reg = 0x78; // REST1_PERIOD
-            err = paw3395_spi_read(dev, reg, &val);
+            err = paw3395_read_config(dev, reg, &val);
             if (err) return err;
             *period_ms = val * 1; // 1ms units
             break;
         case 2:
             reg = 0x7A; // REST2_PERIOD
-            err = paw3395_spi_read(dev, reg, &val);
+            err = paw3395_read_config(dev, reg, &val);
             if (err) return err;
             *period_ms = val * 4; // 4ms units
             break;
         case 3:
             reg = 0x7C; // REST3_PERIOD
-            err = paw3395_spi_read(dev, reg, &val);
+            err = paw3395_read_config(dev, reg, &val);
             if (err) return err;
             *period_ms = val * 8; // 8ms units
             break;
@@ -184,36 +286,52 @@ static uint8_t paw3395_calc_rest3_downshift(uint32_t time_ms, uint16_t rest3_per
     return (uint8_t)val;
 }
 
-static int paw3395_set_cpi(const struct device *dev, uint32_t cpi, bool axis_x) {
-    if (cpi < 50 || cpi > 26000) return -EINVAL;
-    uint16_t regval = CPI_TO_REG(cpi);
-    uint8_t buf[2];
-    sys_put_le16(regval, buf);
-    uint8_t addr[2] = {axis_x ? PAW3395_REG_RESOLUTION_X_LOW : PAW3395_REG_RESOLUTION_Y_LOW,
-                       axis_x ? PAW3395_REG_RESOLUTION_X_HIGH : PAW3395_REG_RESOLUTION_Y_HIGH};
-    for (int i = 0; i < 2; ++i) {
-        int err = paw3395_spi_write(dev, addr[i], buf[i]);
-        if (err) return err;
-    }
-    return paw3395_spi_write(dev, PAW3395_REG_SET_RESOLUTION, 0x01);
+// The new resolution only takes effect once SET_RESOLUTION is written, so
+// both axes go out together and latch with a single commit
+static int paw3395_set_cpi_xy(const struct device *dev, uint32_t cpi_x, uint32_t cpi_y) {
+    if (cpi_x < 50 || cpi_x > 26000 || cpi_y < 50 || cpi_y > 26000) return -EINVAL;
+    uint16_t x = CPI_TO_REG(cpi_x);
+    uint16_t y = CPI_TO_REG(cpi_y);
+    const struct pixart_reg_write writes[] = {
+        {PAW3395_REG_RESOLUTION_X_LOW, x & 0xFF},
+        {PAW3395_REG_RESOLUTION_X_HIGH, x >> 8},
+        {PAW3395_REG_RESOLUTION_Y_LOW, y & 0xFF},
+        {PAW3395_REG_RESOLUTION_Y_HIGH, y >> 8},
+    };
+    const struct pixart_reg_write commit = {PAW3395_REG_SET_RESOLUTION, 0x01};
+    return paw3395_update_regs(dev, writes, ARRAY_SIZE(writes), &commit);
 }
 
-static int paw3395_set_cpi_enum(const struct device *dev, paw3395_cpi_enum_t cpi_choice, bool axis_x) {
-    if (cpi_choice < 0 || cpi_choice >= PAW3395_CPI_COUNT)
-        return -EINVAL;
-    return paw3395_set_cpi(dev, paw3395_cpi_choices[cpi_choice], axis_x);
+// Current CPI of one axis, from the shadow
+static int paw3395_get_cpi(const struct device *dev, bool axis_x, uint32_t *cpi) {
+    uint8_t lo, hi;
+    int err = paw3395_read_config(dev, axis_x ? PAW3395_REG_RESOLUTION_X_LOW : PAW3395_REG_RESOLUTION_Y_LOW, &lo);
+    if (err) return err;
+    err = paw3395_read_config(dev, axis_x ? PAW3395_REG_RESOLUTION_X_HIGH : PAW3395_REG_RESOLUTION_Y_HIGH, &hi);
+    if (err) return err;
+    *cpi = ((uint32_t)((hi << 8) | lo) + 1) * 50;
+    return 0;
 }
 
-static int paw3395_set_cpi_all(const struct device *dev, paw3395_cpi_enum_t cpi) {
-    int err = paw3395_set_cpi_enum(dev, cpi, true);
+static int paw3395_set_cpi(const struct device *dev, uint32_t cpi, bool axis_x) {
+    uint32_t other;
+    int err = paw3395_get_cpi(dev, !axis_x, &other);
     if (err) return err;
-    return paw3395_set_cpi_enum(dev, cpi, false);
+    return axis_x ? paw3395_set_cpi_xy(dev, cpi, other) : paw3395_set_cpi_xy(dev, other, cpi);
+}
+
+static int paw3395_set_cpi_all(const struct device *dev, paw3395_cpi_enum_t cpi) {
+    if (cpi < 0 || cpi >= PAW3395_CPI_COUNT)
+        return -EINVAL;
+    return paw3395_set_cpi_xy(dev, paw3395_cpi_choices[cpi], paw3395_cpi_choices[cpi]);
 }
 
 static int paw3395_set_lift_cutoff(const struct device *dev, uint8_t value) {
-    int err = paw3395_spi_write(dev, PAW3395_REG_LIFT_CONFIG_H, value);
-    if (err) return err;
-    return paw3395_spi_write(dev, PAW3395_REG_LIFT_CONFIG_L, value);
+    const struct pixart_reg_write writes[] = {
+        {PAW3395_REG_LIFT_CONFIG_H, value},
+        {PAW3395_REG_LIFT_CONFIG_L, value},
+    };
+    return paw3395_update_regs(dev, writes, ARRAY_SIZE(writes), NULL);
 }
 
 static int paw3395_set_power_saving(const struct device *dev) {
@@ -222,7 +340,8 @@ static int paw3395_set_power_saving(const struct device *dev) {
     // set rest period 1 to 5ms
     err |= paw3395_set_rest_period(dev, 1, 5);
 
-    // get all rest periods to calculate downshift values
+    // get all rest periods to calculate downshift values, rest1 comes
+    // from the shadow and the others are only read over SPI once
     uint16_t rest1_period_ms = 1;
     uint16_t rest2_period_ms = 1;
     uint16_t rest3_period_ms = 1;
@@ -240,30 +359,384 @@ static int paw3395_set_power_saving(const struct device *dev) {
         return -EINVAL;
     }
 
-    // set rest1 downshift time to 30s
-    uint8_t rest1_downshift = paw3395_calc_rest1_downshift(PAW3395_REST1_DOWNSHIFT_MS, rest1_period_ms);
-    err = paw3395_spi_write(dev, PAW3395_REG_REST1_DOWNSHIFT, rest1_downshift);
-    if (err) return err;
+    // rest1 downshift 30s, rest2 400s, rest3 5000s
+    const struct pixart_reg_write writes[] = {
+        {PAW3395_REG_REST1_DOWNSHIFT,
+         paw3395_calc_rest1_downshift(PAW3395_REST1_DOWNSHIFT_MS, rest1_period_ms)},
+        {PAW3395_REG_REST2_DOWNSHIFT,
+         paw3395_calc_rest2_downshift(PAW3395_REST2_DOWNSHIFT_MS, rest2_period_ms)},
+        {PAW3395_REG_REST3_DOWNSHIFT,
+         paw3395_calc_rest3_downshift(PAW3395_REST3_DOWNSHIFT_MS, rest3_period_ms)},
+    };
+    return paw3395_update_regs(dev, writes, ARRAY_SIZE(writes), NULL);
+}
 
-    // set rest2 downshift time to 400s
-    uint8_t rest2_downshift = paw3395_calc_rest2_downshift(PAW3395_REST2_DOWNSHIFT_MS, rest2_period_ms);
-    err = paw3395_spi_write(dev, PAW3395_REG_REST2_DOWNSHIFT, rest2_downshift);
-    if (err) return err;
+static int paw3395_motion_burst(const struct device *dev, uint8_t *buf, size_t len) {
+    struct paw3395_data *data = dev->data;
+    return pixart_spi_burst_read(&data->base.spi, PAW3395_REG_MOTION_BURST, buf, len);
+}
 
-    // set rest3 downshift time to 5000s
-    uint8_t rest3_downshift = paw3395_calc_rest3_downshift(PAW3395_REST3_DOWNSHIFT_MS, rest3_period_ms);
-    err = paw3395_spi_write(dev, PAW3395_REG_REST3_DOWNSHIFT, rest3_downshift);
-    if (err) return err;
+static void paw3395_script_start(struct paw3395_script_state *state,
+                                 const struct paw3395_script_step *script) {
+    state->pc = script;
+    state->polls = 0;
+}
+
+// Run steps until the script ends or has to wait for a millisecond or more.
+// Returns 0 when done, the wait in microseconds before the next call, or a
+// negative error. Short delays are busy-waited in place.
+static int paw3395_script_resume(const struct device *dev, struct paw3395_script_state *state) {
+    struct paw3395_data *data = dev->data;
+    uint8_t val = 0;
+    int ret = 0;
+
+    // Steps run back to back under one bus lock with NCS held, spaced by
+    // the datasheet minimums
+    pixart_spi_begin(&data->base.spi);
+
+    while (ret == 0 && state->pc->op != PAW3395_OP_END) {
+        const struct paw3395_script_step *step = state->pc++;
+
+        switch (step->op) {
+            case PAW3395_OP_WRITE:
+                if (step->reg == PAW3395_REG_BANK_SELECT && step->val == data->bank) break;
+                ret = pixart_spi_write(&data->base.spi, step->reg, step->val);
+                if (step->reg == PAW3395_REG_BANK_SELECT) {
+                    data->bank = ret ? PAW3395_BANK_UNKNOWN : step->val;
+                } else if (ret == 0 && step->reg == PAW3395_REG_POWER_UP_RESET) {
+                    // Only the power-up script writes 0x3A, back to defaults in bank 0
+                    data->bank = 0;
+                    paw3395_shadow_invalidate(data);
+                } else if (ret == 0) {
+                    paw3395_shadow_set(data, step->reg, step->val);
+                }
+                break;
+            case PAW3395_OP_READ:
+                ret = pixart_spi_read(&data->base.spi, step->reg, &val);
+                break;
+            case PAW3395_OP_DELAY_US:
+                if (step->arg >= 1000) {
+                    ret = step->arg;
+                } else {
+                    k_busy_wait(step->arg);
+                }
+                break;
+            case PAW3395_OP_POLL:
+                ret = pixart_spi_read(&data->base.spi, step->reg, &val);
+                if (ret) break;
+                if (val == step->val) {
+                    state->pc += step->skip;
+                } else if (++state->polls < step->arg) {
+                    state->pc = step; // read again in 1ms
+                    ret = 1000;
+                    break;
+                } else {
+                    LOG_WRN("Register 0x%02X did not reach 0x%02X", step->reg, step->val);
+                }
+                state->polls = 0;
+                break;
+            default:
+                ret = -EINVAL;
+                break;
+        }
+    }
+
+    pixart_spi_end(&data->base.spi);
+    return ret;
+}
+
+// Run a script to completion from the calling thread
+static int paw3395_run_script(const struct device *dev, const struct paw3395_script_step *script) {
+    struct paw3395_script_state state;
+    int ret;
+
+    paw3395_script_start(&state, script);
+    while ((ret = paw3395_script_resume(dev, &state)) > 0) {
+        k_usleep(ret);
+    }
+    return ret;
+}
+
+// Write a group of bank 0 configuration registers in one CS-held transfer,
+// leaving out the ones the shadow says already hold the value. `commit` is
+// written last, and only if something else was.
+static int paw3395_update_regs(const struct device *dev, const struct pixart_reg_write *writes,
+                               size_t count, const struct pixart_reg_write *commit) {
+    struct paw3395_data *data = dev->data;
+    struct pixart_reg_write batch[PAW3395_MAX_REG_WRITES + 2];
+    size_t n = 0;
+    uint8_t cached;
+    int err;
+
+    if (count > PAW3395_MAX_REG_WRITES) return -EINVAL;
+
+    // Hold the bus so the shadow can't change between the compare and the write
+    pixart_spi_begin(&data->base.spi);
+    if (data->bank != 0) {
+        batch[n++] = (struct pixart_reg_write){PAW3395_REG_BANK_SELECT, 0x00};
+    }
+    size_t first = n;
+    for (size_t i = 0; i < count; ++i) {
+        if (paw3395_shadow_get(data, writes[i].reg, &cached) && cached == writes[i].val) continue;
+        batch[n++] = writes[i];
+    }
+    if (n == first) {
+        pixart_spi_end(&data->base.spi);
+        return 0;
+    }
+    if (commit) {
+        batch[n++] = *commit;
+    }
 
+    err = pixart_spi_write_batch(&data->base.spi, batch, n);
+    if (err) {
+        // Don't know how far it got
+        data->bank = PAW3395_BANK_UNKNOWN;
+        paw3395_shadow_invalidate(data);
+    } else {
+        data->bank = 0;
+        for (size_t i = first; i < n; ++i) {
+            paw3395_shadow_set(data, batch[i].reg, batch[i].val);
+        }
+    }
+    pixart_spi_end(&data->base.spi);
     return err;
 }
 
-static int paw3395_motion_burst(const struct device *dev, uint8_t *buf, size_t len) {
-    uint8_t reg = PAW3395_REG_MOTION_BURST;
-    // Use the transceive function: send reg, receive burst data
-    return paw3395_spi_transceive(dev, &reg, 1, buf, len);
+// Switch the run mode as one transaction: the table goes out under the bus
+// lock so no motion burst lands between two banks, and a failed switch is
+// rolled back to the previous mode.
+static int paw3395_set_run_mode(const struct device *dev, enum paw3395_run_mode mode) {
+    struct paw3395_data *data = dev->data;
+
+    if (mode < 0 || mode >= RUN_MODE_COUNT) return -EINVAL;
+    if (mode == data->run_mode) return 0;
+
+    int err = paw3395_run_script(dev, paw3395_mode_scripts[mode]);
+    if (err) {
+        LOG_ERR("Failed to switch to run mode %d: %d", mode, err);
+        if (paw3395_run_script(dev, paw3395_mode_scripts[data->run_mode])) {
+            LOG_ERR("Failed to restore run mode %d", data->run_mode);
+        }
+        return err;
+    }
+
+    LOG_DBG("Run mode %d -> %d", data->run_mode, mode);
+    data->run_mode = mode;
+    return 0;
 }
 
+static void paw3395_decode_burst(const uint8_t *buf, struct paw3395_motion_frame *frame) {
+    frame->motion = buf[PAW3395_MOTION];
+    frame->observation = buf[PAW3395_OBSERVATION_POS];
+    frame->dx = (int16_t)sys_get_le16(&buf[PAW3395_DX_POS]);
+    frame->dy = (int16_t)sys_get_le16(&buf[PAW3395_DY_POS]);
+    frame->squal = buf[PAW3395_SQUAL_POS];
+    frame->raw_data_sum = buf[PAW3395_RAW_DATA_SUM_POS];
+    frame->raw_data_max = buf[PAW3395_RAW_DATA_MAX_POS];
+    frame->raw_data_min = buf[PAW3395_RAW_DATA_MIN_POS];
+    frame->shutter = sys_get_be16(&buf[PAW3395_SHUTTER_POS]);
+}
+
+// Map a channel onto the decoded frame, -ENOTSUP if the channel is unknown
+static int paw3395_frame_channel(const struct paw3395_motion_frame *frame, enum sensor_channel chan,
+                                 int32_t *out) {
+    switch ((uint32_t)chan) {
+        case SENSOR_CHAN_POS_DX:
+            *out = frame->dx;
+            break;
+        case SENSOR_CHAN_POS_DY:
+            *out = frame->dy;
+            break;
+        case PAW3395_CHAN_MOTION:
+            *out = frame->motion;
+            break;
+        case PAW3395_CHAN_LIFT:
+            *out = (frame->motion & PAW3395_MOTION_LIFT) ? 1 : 0;
+            break;
+        case PAW3395_CHAN_OP_MODE:
+            *out = (frame->motion & PAW3395_MOTION_OP_MODE_MASK) >> PAW3395_MOTION_OP_MODE_SHIFT;
+            break;
+        case PAW3395_CHAN_SQUAL:
+            *out = frame->squal;
+            break;
+        case PAW3395_CHAN_RAW_DATA_SUM:
+            *out = frame->raw_data_sum;
+            break;
+        case PAW3395_CHAN_SHUTTER:
+            *out = frame->shutter;
+            break;
+        default:
+            return -ENOTSUP;
+    }
+    return 0;
+}
+
+#ifdef CONFIG_PAW3395_ASYNC
+// Motion burst through the shared transport, so it is serialized with
+// register traffic and keeps tSRAD. Completes from the transport work queue.
+static void paw3395_submit_done(int result, void *userdata) {
+    const struct device *dev = userdata;
+    struct paw3395_data *data = dev->data;
+    struct rtio_iodev_sqe *iodev_sqe = data->pending_sqe;
+
+    data->pending_sqe = NULL;
+    if (result < 0) {
+        rtio_iodev_sqe_err(iodev_sqe, result);
+    } else {
+        rtio_iodev_sqe_ok(iodev_sqe, 0);
+    }
+}
+
+static void paw3395_submit_burst(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe) {
+    struct paw3395_data *data = dev->data;
+    struct paw3395_encoded_data *edata;
+    uint8_t *buf;
+    uint32_t buf_len;
+
+    int err = rtio_sqe_rx_buf(iodev_sqe, sizeof(*edata), sizeof(*edata), &buf, &buf_len);
+    if (err) {
+        rtio_iodev_sqe_err(iodev_sqe, err);
+        return;
+    }
+    edata = (struct paw3395_encoded_data *)buf;
+    edata->timestamp = k_ticks_to_ns_floor64(k_uptime_ticks());
+    edata->cycles = k_cycle_get_32();
+    edata->irq_cycles = data->irq_cycles;
+
+    data->pending_sqe = iodev_sqe;
+    err = pixart_spi_burst_read_async(&data->base.spi, PAW3395_REG_MOTION_BURST, edata->burst,
+                                      sizeof(edata->burst), paw3395_submit_done, (void *)dev);
+    if (err) {
+        data->pending_sqe = NULL;
+        rtio_iodev_sqe_err(iodev_sqe, err);
+    }
+}
+
+// Motion IRQ while streaming: the SPI cannot be started from ISR context
+static void paw3395_stream_work_handler(struct k_work *work) {
+    struct pixart_data *base = CONTAINER_OF(work, struct pixart_data, trigger_handler_work);
+    const struct device *dev = base->dev;
+    struct paw3395_data *data = dev->data;
+    struct rtio_iodev_sqe *iodev_sqe = data->stream_sqe;
+
+    if (iodev_sqe == NULL) return;
+    data->stream_sqe = NULL;
+    paw3395_submit_burst(dev, iodev_sqe);
+}
+
+static void paw3395_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe) {
+    const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+    const struct pixart_config *cfg = dev->config;
+    struct paw3395_data *data = dev->data;
+
+    if (!data->ready || data->pending_sqe != NULL) {
+        rtio_iodev_sqe_err(iodev_sqe, -EBUSY);
+        return;
+    }
+
+    if (!read_cfg->is_streaming) {
+        paw3395_submit_burst(dev, iodev_sqe);
+        return;
+    }
+
+    // Streaming: park the request until the motion pin fires
+    for (size_t i = 0; i < read_cfg->count; ++i) {
+        if (read_cfg->triggers[i].trigger != SENSOR_TRIG_DATA_READY) {
+            rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+            return;
+        }
+    }
+    data->stream_sqe = iodev_sqe;
+    gpio_add_callback(cfg->irq_gpio.port, &data->base.irq_gpio_cb);
+    int err = gpio_pin_interrupt_configure_dt(&cfg->irq_gpio, GPIO_INT_EDGE_TO_ACTIVE);
+    if (err) {
+        data->stream_sqe = NULL;
+        rtio_iodev_sqe_err(iodev_sqe, err);
+    }
+}
+
+int paw3395_decode_motion(const uint8_t *buf, struct paw3395_motion_frame *out) {
+    const struct paw3395_encoded_data *edata = (const struct paw3395_encoded_data *)buf;
+
+    paw3395_decode_burst(edata->burst, out);
+    out->timestamp = edata->cycles;
+    out->irq_timestamp = edata->irq_cycles;
+    if (!(out->motion & PAW3395_MOTION_MOT)) {
+        out->dx = 0;
+        out->dy = 0;
+        return -ENODATA;
+    }
+    return 0;
+}
+
+static int paw3395_decoder_get_frame_count(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+                                           uint16_t *frame_count) {
+    struct paw3395_motion_frame frame = {0};
+    int32_t val;
+
+    ARG_UNUSED(buffer);
+    if (chan_spec.chan_idx != 0) return -ENOTSUP;
+    if (paw3395_frame_channel(&frame, chan_spec.chan_type, &val)) return -ENOTSUP;
+    *frame_count = 1;
+    return 0;
+}
+
+static int paw3395_decoder_get_size_info(struct sensor_chan_spec chan_spec, size_t *base_size,
+                                         size_t *frame_size) {
+    struct paw3395_motion_frame frame = {0};
+    int32_t val;
+
+    if (paw3395_frame_channel(&frame, chan_spec.chan_type, &val)) return -ENOTSUP;
+    *base_size = sizeof(struct sensor_q31_data);
+    *frame_size = sizeof(struct sensor_q31_sample_data);
+    return 0;
+}
+
+static int paw3395_decoder_decode(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+                                  uint32_t *fit, uint16_t max_count, void *data_out) {
+    const struct paw3395_encoded_data *edata = (const struct paw3395_encoded_data *)buffer;
+    struct sensor_q31_data *out = data_out;
+    struct paw3395_motion_frame frame;
+    int32_t val;
+
+    if (*fit != 0 || max_count == 0) return 0;
+    paw3395_decode_burst(edata->burst, &frame);
+    if (paw3395_frame_channel(&frame, chan_spec.chan_type, &val)) return -ENOTSUP;
+
+    // No motion latched: there is no delta frame to hand out
+    bool is_delta = chan_spec.chan_type == SENSOR_CHAN_POS_DX ||
+                    chan_spec.chan_type == SENSOR_CHAN_POS_DY;
+    if (is_delta && !(frame.motion & PAW3395_MOTION_MOT)) return 0;
+
+    // Every field fits in 16 bits: q31 with shift 16, value = val * 2^15 * 2^(16 - 31)
+    out->header.base_timestamp_ns = edata->timestamp;
+    out->header.reading_count = 1;
+    out->shift = 16;
+    out->readings[0].value = (q31_t)val * (1 << 15);
+    *fit = 1;
+    return 1;
+}
+
+static bool paw3395_decoder_has_trigger(const uint8_t *buffer, enum sensor_trigger_type trigger) {
+    ARG_UNUSED(buffer);
+    return trigger == SENSOR_TRIG_DATA_READY;
+}
+
+SENSOR_DECODER_API_DT_DEFINE() = {
+    .get_frame_count = paw3395_decoder_get_frame_count,
+    .get_size_info = paw3395_decoder_get_size_info,
+    .decode = paw3395_decoder_decode,
+    .has_trigger = paw3395_decoder_has_trigger,
+};
+
+static int paw3395_get_decoder(const struct device *dev, const struct sensor_decoder_api **decoder) {
+    ARG_UNUSED(dev);
+    *decoder = &SENSOR_DECODER_NAME();
+    return 0;
+}
+#endif /* CONFIG_PAW3395_ASYNC */
+
 static int paw3395_sample_fetch(const struct device *dev, enum sensor_channel chan) {
     struct paw3395_data *data = dev->data;
     uint8_t buf[PAW3395_BURST_SIZE];
@@ -271,33 +744,56 @@ static int paw3395_sample_fetch(const struct device *dev, enum sensor_channel ch
     if (!data->ready) return -EBUSY;
     int err = paw3395_motion_burst(dev, buf, sizeof(buf));
     if (err) return err;
-    
-    data->x = (int16_t)sys_get_le16(&buf[PAW3395_DX_POS]);
-    data->y = (int16_t)sys_get_le16(&buf[PAW3395_DY_POS]);
-    
+
+    // Nothing moved since the last burst: skip the decode, the caller has
+    // nothing to report
+    if (!(buf[PAW3395_MOTION] & PAW3395_MOTION_MOT)) {
+        data->frame.dx = 0;
+        data->frame.dy = 0;
+        return -ENODATA;
+    }
+
+    paw3395_decode_burst(buf, &data->frame);
     return 0;
 }
 
-static int paw3395_channel_get(const struct device *dev, enum sensor_channel chan, struct sensor_value *val) {
+bool paw3395_is_ready(const struct device *dev) {
+    struct paw3395_data *data = dev->data;
+    return data->ready;
+}
+
+int paw3395_read_motion(const struct device *dev, struct paw3395_motion_frame *out) {
     struct paw3395_data *data = dev->data;
+    uint8_t buf[PAW3395_BURST_SIZE];
+
     if (!data->ready) return -EBUSY;
-    switch (chan) {
-        case SENSOR_CHAN_POS_DX:
-            val->val1 = data->x;
-            val->val2 = 0;
-            break;
-        case SENSOR_CHAN_POS_DY:
-            val->val1 = data->y;
-            val->val2 = 0;
-            break;
-        default:
-            return -ENOTSUP;
+    out->timestamp = k_cycle_get_32();
+    out->irq_timestamp = data->irq_cycles;
+    int err = paw3395_motion_burst(dev, buf, sizeof(buf));
+    if (err) return err;
+
+    paw3395_decode_burst(buf, out);
+    if (!(out->motion & PAW3395_MOTION_MOT)) {
+        out->dx = 0;
+        out->dy = 0;
+        return -ENODATA;
     }
     return 0;
 }
 
+static int paw3395_channel_get(const struct device *dev, enum sensor_channel chan, struct sensor_value *val) {
+    struct paw3395_data *data = dev->data;
+    if (!data->ready) return -EBUSY;
+    int err = paw3395_frame_channel(&data->frame, chan, &val->val1);
+    if (err) return err;
+    val->val2 = 0;
+    return 0;
+}
+
 static int paw3395_attr_set(const struct device *dev, enum sensor_channel chan, enum sensor_attribute attr, const struct sensor_value *val) {
+    struct paw3395_data *data = dev->data;
     if (chan != SENSOR_CHAN_ALL) return -ENOTSUP;
+    if (!data->ready) return -EBUSY;
     switch ((uint32_t)attr) {
         case PAW3395_ATTR_X_CPI:
             return paw3395_set_cpi(dev, val->val1, true);
@@ -306,15 +802,17 @@ static int paw3395_attr_set(const struct device *dev, enum sensor_channel chan,
         case PAW3395_ATTR_CPI_ALL:
             return paw3395_set_cpi_all(dev, (paw3395_cpi_enum_t)val->val1);
         case PAW3395_ATTR_REST1_DOWNSHIFT_TIME:
-            return paw3395_spi_write(dev, PAW3395_REG_REST1_DOWNSHIFT, val->val1 / 1000);
+            return paw3395_write_config(dev, PAW3395_REG_REST1_DOWNSHIFT, val->val1 / 1000);
         case PAW3395_ATTR_REST2_DOWNSHIFT_TIME:
-            return paw3395_spi_write(dev, PAW3395_REG_REST2_DOWNSHIFT, val->val1 / 1000);
+            return paw3395_write_config(dev, PAW3395_REG_REST2_DOWNSHIFT, val->val1 / 1000);
         case PAW3395_ATTR_REST3_SAMPLE_TIME:
-            return paw3395_spi_write(dev, PAW3395_REG_REST3_DOWNSHIFT, val->val1 / 1000);
+            return paw3395_write_config(dev, PAW3395_REG_REST3_DOWNSHIFT, val->val1 / 1000);
         case PAW3395_ATTR_RUN_DOWNSHIFT_TIME:
-            return paw3395_spi_write(dev, PAW3395_REG_RUN_DOWNSHIFT, val->val1 / 1000);
+            return paw3395_write_config(dev, PAW3395_REG_RUN_DOWNSHIFT, val->val1 / 1000);
         case PAW3395_ATTR_LIFT_CUTOFF:
             return paw3395_set_lift_cutoff(dev, val->val1);
+        case PAW3395_ATTR_RUN_MODE:
+            return paw3395_set_run_mode(dev, (enum paw3395_run_mode)val->val1);
         default:
             return -ENOTSUP;
     }
@@ -323,6 +821,12 @@ static int paw3395_attr_set(const struct device *dev, enum sensor_channel chan,
 // IRQ handler and trigger support for high-performance, low-latency operation
 static void paw3395_irq_callback(const struct device *port, struct gpio_callback *cb, uint32_t pins) {
     struct paw3395_data *data = CONTAINER_OF(cb, struct paw3395_data, base.irq_gpio_cb);
+    data->irq_cycles = k_cycle_get_32();
+#ifdef CONFIG_PAW3395_ASYNC
+    if (data->stream_sqe != NULL) {
+        k_work_submit(&data->base.trigger_handler_work);
+    }
+#endif
     if (data->base.data_ready_handler) {
         data->base.data_ready_handler(data->base.dev, data->base.trigger);
     }
@@ -350,6 +854,69 @@ static int paw3395_trigger_set(const struct device *dev, const struct sensor_tri
     return 0;
 }
 
+static int paw3395_init_configure(const struct device *dev) {
+    // Check product ID
+    uint8_t prod_id = 0;
+    struct paw3395_data *data = dev->data;
+    int err = pixart_spi_read(&data->base.spi, PAW3395_REG_PRODUCT_ID, &prod_id);
+    if (err) return err;
+    LOG_DBG("PAW3395 product ID: 0x%02X", prod_id);
+    if (prod_id != PAW3395_PRODUCT_ID) {
+        LOG_ERR("Product ID mismatch: expected 0x%02X, got 0x%02X", PAW3395_PRODUCT_ID, prod_id);
+        // return -ENODEV;
+    }
+    // Set default CPI, power saving, etc.
+    LOG_DBG("Setting default CPI and power saving");
+    err = paw3395_set_cpi_all(dev, PAW3395_CPI_1600); // Default CPI
+    if (err) return err;
+    return paw3395_set_power_saving(dev);
+}
+
+// Power-up state machine. Every wait in the script goes back to the work
+// queue, so the rest of the system keeps booting while the sensor comes up.
+static void paw3395_init_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *base = CONTAINER_OF(dwork, struct pixart_data, init_work);
+    const struct device *dev = base->dev;
+    struct paw3395_data *data = dev->data;
+    int ret;
+
+    switch (base->async_init_step) {
+        case PAW3395_INIT_STEP_SCRIPT:
+            ret = paw3395_script_resume(dev, &data->script);
+            if (ret > 0) {
+                k_work_schedule(dwork, K_USEC(ret));
+                return;
+            }
+            if (ret < 0) {
+                LOG_ERR("Power-up script failed: %d", ret);
+                base->err = ret;
+                return;
+            }
+            base->async_init_step = PAW3395_INIT_STEP_CONFIGURE;
+            __fallthrough;
+        case PAW3395_INIT_STEP_CONFIGURE:
+            ret = paw3395_init_configure(dev);
+            if (ret) {
+                LOG_ERR("Failed to configure PAW3395: %d", ret);
+                base->err = ret;
+                return;
+            }
+            base->async_init_step = PAW3395_INIT_STEP_DONE;
+            data->ready = true;
+            LOG_INF("PAW3395 initialization complete in %u us",
+                    k_cyc_to_us_floor32(k_cycle_get_32() - data->init_start));
+            // Let a registered data-ready handler drain anything that moved
+            // while we were powering up
+            if (base->data_ready_handler) {
+                base->data_ready_handler(dev, base->trigger);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
 static int paw3395_init(const struct device *dev) {
     struct paw3395_data *data = dev->data;
     const struct pixart_config *cfg = dev->config;
@@ -367,56 +934,21 @@ static int paw3395_init(const struct device *dev) {
         return err;
     }
     gpio_init_callback(&data->base.irq_gpio_cb, paw3395_irq_callback, BIT(cfg->irq_gpio.pin));
-    // Drive NCS high, and then low to reset the SPI port.
-    k_msleep(50);
-    // Power-up reset
-    k_msleep(5);
-    paw3395_spi_write(dev, PAW3395_REG_POWER_UP_RESET, 0x5A);
-    k_msleep(5);
-    // Upload power-up register settings
-    LOG_DBG("Uploading power-up register settings (part 1)");
-    for (size_t i = 0; i < paw3395_pwrup_registers_length1; ++i){
-        paw3395_spi_write(dev, paw3395_pwrup_registers_addr1[i], paw3395_pwrup_registers_data1[i]);
-    }
-    k_msleep(1);
-
-    uint8_t reg_6c = 0;
-    for (int i = 0; i < 60; ++i) {
-        paw3395_spi_read(dev, 0x6C, &reg_6c);
-        if (reg_6c == 0x80) break;
-        k_msleep(1);
-    }
-    if (reg_6c != 0x80) {
-        LOG_WRN("Register 0x6C did not reach 0x80, performing workaround");
-        paw3395_spi_write(dev, 0x7F, 0x14);
-        paw3395_spi_write(dev, 0x6C, 0x00);
-        paw3395_spi_write(dev, 0x7F, 0x00);
-    }
-    paw3395_spi_write(dev, 0x22, 0x00);
-    paw3395_spi_write(dev, 0x55, 0x00);
-    paw3395_spi_write(dev, 0x7F, 0x07);
-    paw3395_spi_write(dev, 0x40, 0x40);
-    paw3395_spi_write(dev, 0x7F, 0x00);
-    paw3395_spi_write(dev, 0x68, 0x01);
-
-    LOG_DBG("Uploading power-up register settings (part 2)");
-    for (size_t i = 0; i < paw3395_pwrup_registers_length2; ++i){
-        paw3395_spi_write(dev, paw3395_pwrup_registers_addr2[i], paw3395_pwrup_registers_data2[i]);
-    }
-    // Check product ID
-    uint8_t prod_id = 0;
-    paw3395_spi_read(dev, PAW3395_REG_PRODUCT_ID, &prod_id);
-    LOG_DBG("PAW3395 product ID: 0x%02X", prod_id);
-    if (prod_id != PAW3395_PRODUCT_ID) {
-        LOG_ERR("Product ID mismatch: expected 0x%02X, got 0x%02X", PAW3395_PRODUCT_ID, prod_id);
-        // return -ENODEV;
-    }
-    // Set default CPI, power saving, etc.
-    LOG_DBG("Setting default CPI and power saving");
-    paw3395_set_cpi_all(dev, PAW3395_CPI_1600); // Default CPI
-    paw3395_set_power_saving(dev);
-    data->ready = true;
-    LOG_INF("PAW3395 initialization complete");
+#ifdef CONFIG_PAW3395_ASYNC
+    k_work_init(&data->base.trigger_handler_work, paw3395_stream_work_handler);
+#endif
+    // The sensor comes up in the background, the API returns -EBUSY until
+    // data->ready is set. The first SPI access drives NCS high then low,
+    // resetting the SPI port, and only waits for VDD if we got here sooner
+    // than the power-up time.
+    data->init_start = k_cycle_get_32();
+    pixart_spi_init(&data->base.spi, &cfg->bus, &paw3395_spi_timing);
+    data->bank = PAW3395_BANK_UNKNOWN;
+    paw3395_shadow_invalidate(data);
+    paw3395_script_start(&data->script, paw3395_pwrup_script);
+    data->base.async_init_step = PAW3395_INIT_STEP_SCRIPT;
+    k_work_init_delayable(&data->base.init_work, paw3395_init_work_handler);
+    k_work_schedule(&data->base.init_work, K_TIMEOUT_ABS_MS(PAW3395_POWER_UP_MS));
     return 0;
 }
 
@@ -425,12 +957,17 @@ static const struct sensor_driver_api paw3395_api = {
     .channel_get = paw3395_channel_get,
     .attr_set = paw3395_attr_set,
     .trigger_set = paw3395_trigger_set,
+#ifdef CONFIG_PAW3395_ASYNC
+    .submit = paw3395_submit,
+    .get_decoder = paw3395_get_decoder,
+#endif
 };
 
 // Expansion macro to define driver instances
 #define PAW3395_DEFINE(inst)                                                 \
     static const struct pixart_config paw3395_config_##inst = {             \
-        .bus = SPI_DT_SPEC_INST_GET(inst, SPI_OP_MODE_MASTER | SPI_WORD_SET(8), 0),           \
+        .bus = SPI_DT_SPEC_INST_GET(inst, SPI_OP_MODE_MASTER | SPI_WORD_SET(8) |      \
+                                    SPI_MODE_CPOL | SPI_MODE_CPHA, 0),               \
         .irq_gpio = GPIO_DT_SPEC_INST_GET(inst, irq_gpios),                 \
     };                                                                       \
                                                                              \
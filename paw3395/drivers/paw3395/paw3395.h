@@ -36,6 +36,37 @@ enum paw3395_attribute {
     PAW3395_ATTR_LIFT_CUTOFF,
 };
 
+// Extra values decoded from the motion burst, read with sensor_channel_get()
+enum paw3395_channel {
+    PAW3395_CHAN_MOTION = SENSOR_CHAN_PRIV_START, // raw MOTION register
+    PAW3395_CHAN_LIFT,                            // 1 when lifted off the surface
+    PAW3395_CHAN_OP_MODE,                         // 0 run, 1..3 rest1..rest3
+    PAW3395_CHAN_SQUAL,                           // surface quality
+    PAW3395_CHAN_RAW_DATA_SUM,
+    PAW3395_CHAN_SHUTTER,
+};
+
+// MOTION register bits
+#define PAW3395_MOTION_MOT BIT(7)         // motion since last burst
+#define PAW3395_MOTION_LIFT BIT(3)        // lift detected
+#define PAW3395_MOTION_OP_MODE_MASK 0x06  // operating mode, bits 2:1
+#define PAW3395_MOTION_OP_MODE_SHIFT 1
+
+// One decoded motion burst
+struct paw3395_motion_frame {
+    uint8_t motion;       // raw MOTION register, see PAW3395_MOTION_*
+    uint8_t observation;
+    int16_t dx;
+    int16_t dy;
+    uint8_t squal;
+    uint8_t raw_data_sum;
+    uint8_t raw_data_max;
+    uint8_t raw_data_min;
+    uint16_t shutter;
+    uint32_t timestamp;   // k_cycle_get_32() when the burst was started
+    uint32_t irq_timestamp; // k_cycle_get_32() at the latest motion IRQ
+};
+
 typedef enum {
     PAW3395_CPI_800 = 0,
     PAW3395_CPI_1600,
@@ -47,6 +78,37 @@ typedef enum {
     PAW3395_CPI_COUNT
 } paw3395_cpi_enum_t;
 
+/**
+ * @brief Check whether the background power-up has finished.
+ *
+ * The device is ready as soon as init returns, but the sensor itself is
+ * brought up from a work item. Until this returns true every access
+ * fails with -EBUSY. A registered data-ready handler is called once when
+ * power-up completes.
+ */
+bool paw3395_is_ready(const struct device *dev);
+
+/**
+ * @brief Read one motion burst straight into a frame.
+ *
+ * Fast path for the input loop: one SPI burst and one decode, without the
+ * sensor_value conversion and per-channel dispatch of the generic API.
+ *
+ * @retval 0 motion was latched, @p out holds the deltas
+ * @retval -ENODATA no motion since the last burst, dx/dy are zero
+ * @retval -EBUSY sensor not initialized yet
+ */
+int paw3395_read_motion(const struct device *dev, struct paw3395_motion_frame *out);
+
+#ifdef CONFIG_PAW3395_ASYNC
+/**
+ * @brief Decode a buffer produced by sensor_read() on a PAW3395.
+ *
+ * Same return values as paw3395_read_motion().
+ */
+int paw3395_decode_motion(const uint8_t *buf, struct paw3395_motion_frame *out);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,66 @@
+#ifndef ZEPHYR_INCLUDE_PAW3395_EMUL_H_
+#define ZEPHYR_INCLUDE_PAW3395_EMUL_H_
+
+#include <zephyr/drivers/emul.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file paw3395_emul.h
+ * @brief Control interface of the PAW3395 SPI emulator.
+ */
+
+// One step of a motion script, t_us is relative to paw3395_emul_play()
+struct paw3395_emul_motion {
+    uint32_t t_us;
+    int16_t dx;
+    int16_t dy;
+    uint8_t squal;
+};
+
+// SPI traffic seen by the emulator since the last reset of the counters
+struct paw3395_emul_stats {
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t bursts;
+};
+
+/**
+ * @brief Latch motion as if the sensor had just seen it, and assert the
+ * motion pin.
+ */
+void paw3395_emul_add_motion(const struct emul *target, int16_t dx, int16_t dy, uint8_t squal);
+
+/**
+ * @brief Play a motion script from the system work queue.
+ *
+ * The script must stay valid until playback ends. Starting a new script
+ * replaces the one playing.
+ */
+void paw3395_emul_play(const struct emul *target, const struct paw3395_emul_motion *script,
+                       size_t len);
+
+/** @brief Whether a script started with paw3395_emul_play() is still running. */
+bool paw3395_emul_is_playing(const struct emul *target);
+
+/**
+ * @brief Number of 0x6C reads after power-up reset before it reads 0x80.
+ *
+ * UINT32_MAX makes the handshake never complete, which exercises the
+ * driver's fallback.
+ */
+void paw3395_emul_set_handshake_reads(const struct emul *target, uint32_t reads);
+
+/** @brief Read a register from the emulated register file. */
+uint8_t paw3395_emul_get_reg(const struct emul *target, uint8_t bank, uint8_t reg);
+
+void paw3395_emul_get_stats(const struct emul *target, struct paw3395_emul_stats *stats);
+void paw3395_emul_reset_stats(const struct emul *target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_PAW3395_EMUL_H_ */
@@ -4,116 +4,116 @@
 #include <stdlib.h>
 #include "paw3395.h"
 
-///////// Init setting registers //////////////////////
-const size_t paw3395_pwrup_registers_length1 = 137;
-const size_t paw3395_pwrup_registers_length2 = 5;
+///////// Power-up script //////////////////////
+/* Datasheet power-up sequence: reset, init table, 0x6C handshake, tail writes */
+const struct paw3395_script_step paw3395_pwrup_script[] = {
+  /* power-up reset, then at least 5ms before the init table */
+  PAW3395_W(0x3A, 0x5A),
+  PAW3395_DELAY_US(5000),
 
-/* power up registers init: group1 */
-const uint8_t paw3395_pwrup_registers_addr1[] = {
-  0x7F, 0x40, 0x7F, 0x40, 0x7F, 0x55, 0x56, 0x57, 0x58, 0x7F,
-  0x42, 0x43, 0x4B, 0x4D, 0x53, 0x7F, 0x44, 0x4D, 0x51, 0x53,
-  0x55, 0x5A, 0x5B, 0x61, 0x62, 0x6D, 0x6E, 0x70, 0x4A, 0x60,
-  0x7F, 0x6C, 0x6D, 0x6E, 0x53, 0x55, 0x7A, 0x7D, 0x7F, 0x41,
-  0x42, 0x43, 0x7F, 0x71, 0x7F, 0x62, 0x63, 0x65, 0x66, 0x67,
-  0x68, 0x69, 0x6A, 0x6C, 0x6D, 0x51, 0x53, 0x54, 0x71, 0x72,
-  0x73, 0x7F, 0x4A, 0x4C, 0x55, 0x7F, 0x4B, 0x4C, 0x61, 0x62,
-  0x63, 0x7F, 0x4C, 0x56, 0x41, 0x4D, 0x7F, 0x4A, 0x4B, 0x4C,
-  0x41, 0x55, 0x56, 0x49, 0x42, 0x43, 0x44, 0x54, 0x5A, 0x5F,
-  0x5B, 0x5E, 0x7F, 0x48, 0x4F, 0x52, 0x51, 0x54, 0x53, 0x56,
-  0x55, 0x58, 0x57, 0x5A, 0x5B, 0x5C, 0x5D, 0x71, 0x70, 0x73,
-  0x72, 0x75, 0x74, 0x77, 0x76, 0x7F, 0x4C, 0x7F, 0x4F, 0x4E,
-  0x52, 0x51, 0x54, 0x5A, 0x77, 0x47, 0x5B, 0x64, 0x65, 0x66,
-  0x67, 0x78, 0x79, 0x40, 0x55, 0x23, 0x22
-};
-const uint8_t paw3395_pwrup_registers_data1[] = {
-  0x07, 0x41, 0x00, 0x80, 0x0E, 0x0D, 0x1B, 0xE8, 0xD5, 0x14,
-  0xBC, 0x74, 0x20, 0x00, 0x0E, 0x05, 0x04, 0x06, 0x40, 0x40,
-  0xCA, 0xE8, 0xEA, 0x31, 0x64, 0xB8, 0x0F, 0x02, 0x2A, 0x26,
-  0x06, 0x70, 0x60, 0x04, 0x02, 0x11, 0x01, 0x51, 0x07, 0x10,
-  0x32, 0x00, 0x08, 0x4F, 0x09, 0x1F, 0x1F, 0x03, 0x03, 0x1F,
-  0x1F, 0x03, 0x03, 0x1F, 0x1F, 0x04, 0x20, 0x20, 0x0C, 0x07,
-  0x07, 0x0A, 0x14, 0x14, 0x19, 0x14, 0x30, 0x03, 0x0B, 0x0A,
-  0x02, 0x15, 0x02, 0x02, 0x91, 0x0A, 0x0C, 0x10, 0x0C, 0x40,
-  0x25, 0x18, 0x14, 0x0A, 0x00, 0x2D, 0x0C, 0x1A, 0x0D, 0x1E,
-  0x05, 0x0F, 0x0D, 0xDD, 0x03, 0x49, 0x00, 0x5B, 0x00, 0x64,
-  0x00, 0xA5, 0x02, 0x29, 0x47, 0x81, 0x40, 0xDC, 0x07, 0x00,
-  0x08, 0xDC, 0x07, 0x00, 0x08, 0x10, 0xD0, 0x00, 0x63, 0x00,
-  0x63, 0x00, 0x54, 0x10, 0x4F, 0x01, 0x40, 0x60, 0x06, 0x13,
-  0x0F, 0x01, 0x9C, 0x00, 0x02, 0x70, 0x01
-};
+  /* power up registers init: group1 */
+  PAW3395_W(0x7F, 0x07), PAW3395_W(0x40, 0x41), PAW3395_W(0x7F, 0x00), PAW3395_W(0x40, 0x80),
+  PAW3395_W(0x7F, 0x0E), PAW3395_W(0x55, 0x0D), PAW3395_W(0x56, 0x1B), PAW3395_W(0x57, 0xE8),
+  PAW3395_W(0x58, 0xD5), PAW3395_W(0x7F, 0x14), PAW3395_W(0x42, 0xBC), PAW3395_W(0x43, 0x74),
+  PAW3395_W(0x4B, 0x20), PAW3395_W(0x4D, 0x00), PAW3395_W(0x53, 0x0E), PAW3395_W(0x7F, 0x05),
+  PAW3395_W(0x44, 0x04), PAW3395_W(0x4D, 0x06), PAW3395_W(0x51, 0x40), PAW3395_W(0x53, 0x40),
+  PAW3395_W(0x55, 0xCA), PAW3395_W(0x5A, 0xE8), PAW3395_W(0x5B, 0xEA), PAW3395_W(0x61, 0x31),
+  PAW3395_W(0x62, 0x64), PAW3395_W(0x6D, 0xB8), PAW3395_W(0x6E, 0x0F), PAW3395_W(0x70, 0x02),
+  PAW3395_W(0x4A, 0x2A), PAW3395_W(0x60, 0x26), PAW3395_W(0x7F, 0x06), PAW3395_W(0x6C, 0x70),
+  PAW3395_W(0x6D, 0x60), PAW3395_W(0x6E, 0x04), PAW3395_W(0x53, 0x02), PAW3395_W(0x55, 0x11),
+  PAW3395_W(0x7A, 0x01), PAW3395_W(0x7D, 0x51), PAW3395_W(0x7F, 0x07), PAW3395_W(0x41, 0x10),
+  PAW3395_W(0x42, 0x32), PAW3395_W(0x43, 0x00), PAW3395_W(0x7F, 0x08), PAW3395_W(0x71, 0x4F),
+  PAW3395_W(0x7F, 0x09), PAW3395_W(0x62, 0x1F), PAW3395_W(0x63, 0x1F), PAW3395_W(0x65, 0x03),
+  PAW3395_W(0x66, 0x03), PAW3395_W(0x67, 0x1F), PAW3395_W(0x68, 0x1F), PAW3395_W(0x69, 0x03),
+  PAW3395_W(0x6A, 0x03), PAW3395_W(0x6C, 0x1F), PAW3395_W(0x6D, 0x1F), PAW3395_W(0x51, 0x04),
+  PAW3395_W(0x53, 0x20), PAW3395_W(0x54, 0x20), PAW3395_W(0x71, 0x0C), PAW3395_W(0x72, 0x07),
+  PAW3395_W(0x73, 0x07), PAW3395_W(0x7F, 0x0A), PAW3395_W(0x4A, 0x14), PAW3395_W(0x4C, 0x14),
+  PAW3395_W(0x55, 0x19), PAW3395_W(0x7F, 0x14), PAW3395_W(0x4B, 0x30), PAW3395_W(0x4C, 0x03),
+  PAW3395_W(0x61, 0x0B), PAW3395_W(0x62, 0x0A), PAW3395_W(0x63, 0x02), PAW3395_W(0x7F, 0x15),
+  PAW3395_W(0x4C, 0x02), PAW3395_W(0x56, 0x02), PAW3395_W(0x41, 0x91), PAW3395_W(0x4D, 0x0A),
+  PAW3395_W(0x7F, 0x0C), PAW3395_W(0x4A, 0x10), PAW3395_W(0x4B, 0x0C), PAW3395_W(0x4C, 0x40),
+  PAW3395_W(0x41, 0x25), PAW3395_W(0x55, 0x18), PAW3395_W(0x56, 0x14), PAW3395_W(0x49, 0x0A),
+  PAW3395_W(0x42, 0x00), PAW3395_W(0x43, 0x2D), PAW3395_W(0x44, 0x0C), PAW3395_W(0x54, 0x1A),
+  PAW3395_W(0x5A, 0x0D), PAW3395_W(0x5F, 0x1E), PAW3395_W(0x5B, 0x05), PAW3395_W(0x5E, 0x0F),
+  PAW3395_W(0x7F, 0x0D), PAW3395_W(0x48, 0xDD), PAW3395_W(0x4F, 0x03), PAW3395_W(0x52, 0x49),
+  PAW3395_W(0x51, 0x00), PAW3395_W(0x54, 0x5B), PAW3395_W(0x53, 0x00), PAW3395_W(0x56, 0x64),
+  PAW3395_W(0x55, 0x00), PAW3395_W(0x58, 0xA5), PAW3395_W(0x57, 0x02), PAW3395_W(0x5A, 0x29),
+  PAW3395_W(0x5B, 0x47), PAW3395_W(0x5C, 0x81), PAW3395_W(0x5D, 0x40), PAW3395_W(0x71, 0xDC),
+  PAW3395_W(0x70, 0x07), PAW3395_W(0x73, 0x00), PAW3395_W(0x72, 0x08), PAW3395_W(0x75, 0xDC),
+  PAW3395_W(0x74, 0x07), PAW3395_W(0x77, 0x00), PAW3395_W(0x76, 0x08), PAW3395_W(0x7F, 0x10),
+  PAW3395_W(0x4C, 0xD0), PAW3395_W(0x7F, 0x00), PAW3395_W(0x4F, 0x63), PAW3395_W(0x4E, 0x00),
+  PAW3395_W(0x52, 0x63), PAW3395_W(0x51, 0x00), PAW3395_W(0x54, 0x54), PAW3395_W(0x5A, 0x10),
+  PAW3395_W(0x77, 0x4F), PAW3395_W(0x47, 0x01), PAW3395_W(0x5B, 0x40), PAW3395_W(0x64, 0x60),
+  PAW3395_W(0x65, 0x06), PAW3395_W(0x66, 0x13), PAW3395_W(0x67, 0x0F), PAW3395_W(0x78, 0x01),
+  PAW3395_W(0x79, 0x9C), PAW3395_W(0x40, 0x00), PAW3395_W(0x55, 0x02), PAW3395_W(0x23, 0x70),
+  PAW3395_W(0x22, 0x01),
+  PAW3395_DELAY_US(1000),
 
-/* power up registers init: group2 */
-const uint8_t paw3395_pwrup_registers_addr2[] = {
-  0x22, 0x55, 0x7F, 0x40, 0x7F
-};
-const uint8_t paw3395_pwrup_registers_data2[] = {
-  0x00, 0x00, 0x07, 0x40, 0x00
-};
+  /* wait for 0x6C to read 0x80, on timeout force it from bank 0x14 */
+  PAW3395_POLL(0x6C, 0x80, 60, 3),
+  PAW3395_W(0x7F, 0x14),
+  PAW3395_W(0x6C, 0x00),
+  PAW3395_W(0x7F, 0x00),
+
+  /* power up registers init: group2 */
+  PAW3395_W(0x22, 0x00), PAW3395_W(0x55, 0x00), PAW3395_W(0x7F, 0x07), PAW3395_W(0x40, 0x40),
+  PAW3395_W(0x7F, 0x00), PAW3395_W(0x68, 0x01),
 
-///////// Run mode registers //////////////////////
-const size_t paw3395_mode_registers_length[RUN_MODE_COUNT] = {
-    [HP_MODE] = 21,
-    [LP_MODE] = 21,
-    [OFFICE_MODE] = 21,
-    [GAME_MODE] = 19,
+  /* read 0x02..0x06 once to clear any motion latched during init */
+  PAW3395_R(0x02), PAW3395_R(0x03), PAW3395_R(0x04), PAW3395_R(0x05), PAW3395_R(0x06),
+  PAW3395_END,
 };
 
+///////// Run mode scripts //////////////////////
+/* Every script ends back in bank 0 */
+
 /* hp mode registers */
-const uint8_t paw3395_hp_register_addr[] = {
-  0x7F, 0x51, 0x53, 0x61, 0x6E, 0x7F, 0x42, 0x43, 0x7F, 0x51,
-  0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x7F, 0x54, 0x78,
-  0x79
-};
-const uint8_t paw3395_hp_register_data[] = {
-  0x05, 0x40, 0x40, 0x31, 0x0F, 0x07, 0x32, 0x00, 0x0D, 0x00,
-  0x49, 0x00, 0x5B, 0x00, 0x64, 0x02, 0xA5, 0x00, 0x54, 0x01,
-  0x9C
+static const struct paw3395_script_step paw3395_hp_mode_script[] = {
+  PAW3395_W(0x7F, 0x05), PAW3395_W(0x51, 0x40), PAW3395_W(0x53, 0x40), PAW3395_W(0x61, 0x31),
+  PAW3395_W(0x6E, 0x0F), PAW3395_W(0x7F, 0x07), PAW3395_W(0x42, 0x32), PAW3395_W(0x43, 0x00),
+  PAW3395_W(0x7F, 0x0D), PAW3395_W(0x51, 0x00), PAW3395_W(0x52, 0x49), PAW3395_W(0x53, 0x00),
+  PAW3395_W(0x54, 0x5B), PAW3395_W(0x55, 0x00), PAW3395_W(0x56, 0x64), PAW3395_W(0x57, 0x02),
+  PAW3395_W(0x58, 0xA5), PAW3395_W(0x7F, 0x00), PAW3395_W(0x54, 0x54), PAW3395_W(0x78, 0x01),
+  PAW3395_W(0x79, 0x9C),
+  PAW3395_END,
 };
 
 /* lp mode registers */
-const uint8_t paw3395_lp_register_addr[] = {
-  0x7F, 0x51, 0x53, 0x61, 0x6E, 0x7F, 0x42, 0x43, 0x7F, 0x51,
-  0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x7F, 0x54, 0x78,
-  0x79
-};
-const uint8_t paw3395_lp_register_data[] = {
-  0x05, 0x40, 0x40, 0x3B, 0x1F, 0x07, 0x32, 0x00, 0x0D, 0x00,
-  0x49, 0x00, 0x5B, 0x00, 0x64, 0x02, 0xA5, 0x00, 0x54, 0x01,
-  0x9C
+static const struct paw3395_script_step paw3395_lp_mode_script[] = {
+  PAW3395_W(0x7F, 0x05), PAW3395_W(0x51, 0x40), PAW3395_W(0x53, 0x40), PAW3395_W(0x61, 0x3B),
+  PAW3395_W(0x6E, 0x1F), PAW3395_W(0x7F, 0x07), PAW3395_W(0x42, 0x32), PAW3395_W(0x43, 0x00),
+  PAW3395_W(0x7F, 0x0D), PAW3395_W(0x51, 0x00), PAW3395_W(0x52, 0x49), PAW3395_W(0x53, 0x00),
+  PAW3395_W(0x54, 0x5B), PAW3395_W(0x55, 0x00), PAW3395_W(0x56, 0x64), PAW3395_W(0x57, 0x02),
+  PAW3395_W(0x58, 0xA5), PAW3395_W(0x7F, 0x00), PAW3395_W(0x54, 0x54), PAW3395_W(0x78, 0x01),
+  PAW3395_W(0x79, 0x9C),
+  PAW3395_END,
 };
 
 /* office mode registers */
-const uint8_t paw3395_office_register_addr[] = {
-  0x7F, 0x51, 0x53, 0x61, 0x6E, 0x7F, 0x42, 0x43, 0x7F, 0x51,
-  0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x7F, 0x54, 0x78,
-  0x79
-};
-const uint8_t paw3395_office_register_data[] = {
-  0x05, 0x28, 0x30, 0x3B, 0x1F, 0x07, 0x32, 0x00, 0x0D, 0x00,
-  0x49, 0x00, 0x5B, 0x00, 0x64, 0x02, 0xA5, 0x00, 0x52, 0x0A,
-  0x0F
+static const struct paw3395_script_step paw3395_office_mode_script[] = {
+  PAW3395_W(0x7F, 0x05), PAW3395_W(0x51, 0x28), PAW3395_W(0x53, 0x30), PAW3395_W(0x61, 0x3B),
+  PAW3395_W(0x6E, 0x1F), PAW3395_W(0x7F, 0x07), PAW3395_W(0x42, 0x32), PAW3395_W(0x43, 0x00),
+  PAW3395_W(0x7F, 0x0D), PAW3395_W(0x51, 0x00), PAW3395_W(0x52, 0x49), PAW3395_W(0x53, 0x00),
+  PAW3395_W(0x54, 0x5B), PAW3395_W(0x55, 0x00), PAW3395_W(0x56, 0x64), PAW3395_W(0x57, 0x02),
+  PAW3395_W(0x58, 0xA5), PAW3395_W(0x7F, 0x00), PAW3395_W(0x54, 0x52), PAW3395_W(0x78, 0x0A),
+  PAW3395_W(0x79, 0x0F),
+  PAW3395_END,
 };
 
 /* game mode registers */
-const uint8_t paw3395_game_register_addr[] = {
-  0x7F, 0x51, 0x53, 0x61, 0x6E, 0x7F, 0x42, 0x43, 0x7F, 0x51,
-  0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x7F, 0x54
-};
-const uint8_t paw3395_game_register_data[] = {
-  0x05, 0x40, 0x40, 0x31, 0x0F, 0x07, 0x2F, 0x00, 0x0D, 0x12,
-  0xDB, 0x12, 0xDC, 0x12, 0xEA, 0x15, 0x2D, 0x00, 0x55
+static const struct paw3395_script_step paw3395_game_mode_script[] = {
+  PAW3395_W(0x7F, 0x05), PAW3395_W(0x51, 0x40), PAW3395_W(0x53, 0x40), PAW3395_W(0x61, 0x31),
+  PAW3395_W(0x6E, 0x0F), PAW3395_W(0x7F, 0x07), PAW3395_W(0x42, 0x2F), PAW3395_W(0x43, 0x00),
+  PAW3395_W(0x7F, 0x0D), PAW3395_W(0x51, 0x12), PAW3395_W(0x52, 0xDB), PAW3395_W(0x53, 0x12),
+  PAW3395_W(0x54, 0xDC), PAW3395_W(0x55, 0x12), PAW3395_W(0x56, 0xEA), PAW3395_W(0x57, 0x15),
+  PAW3395_W(0x58, 0x2D), PAW3395_W(0x7F, 0x00), PAW3395_W(0x54, 0x55),
+  PAW3395_END,
 };
 
-/* aggregation of all run modes registers */
-const uint8_t* paw3395_mode_registers_addr[] = {
-  [HP_MODE] = paw3395_hp_register_addr,
-  [LP_MODE] = paw3395_lp_register_addr,
-  [OFFICE_MODE] = paw3395_office_register_addr,
-  [GAME_MODE] = paw3395_game_register_addr,
-};
-const uint8_t* paw3395_mode_registers_data[] = {
-  [HP_MODE] = paw3395_hp_register_data,
-  [LP_MODE] = paw3395_lp_register_data,
-  [OFFICE_MODE] = paw3395_office_register_data,
-  [GAME_MODE] = paw3395_game_register_data,
+/* aggregation of all run modes scripts */
+const struct paw3395_script_step *const paw3395_mode_scripts[RUN_MODE_COUNT] = {
+  [HP_MODE] = paw3395_hp_mode_script,
+  [LP_MODE] = paw3395_lp_mode_script,
+  [OFFICE_MODE] = paw3395_office_mode_script,
+  [GAME_MODE] = paw3395_game_mode_script,
 };
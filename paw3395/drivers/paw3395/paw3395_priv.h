@@ -4,17 +4,41 @@
 #include <zephyr/types.h>
 #include <stddef.h>
 
-// Power-up register settings (to be filled as per datasheet or reference)
-extern const size_t paw3395_pwrup_registers_length1;
-extern const uint8_t paw3395_pwrup_registers_addr1[];
-extern const uint8_t paw3395_pwrup_registers_data1[];
-extern const size_t paw3395_pwrup_registers_length2;
-extern const uint8_t paw3395_pwrup_registers_addr2[];
-extern const uint8_t paw3395_pwrup_registers_data2[];
-
-// Run mode register settings
-extern const size_t paw3395_mode_registers_length[];
-extern const uint8_t* paw3395_mode_registers_addr[];
-extern const uint8_t* paw3395_mode_registers_data[];
+// Register scripts: a flat list of steps run in order by paw3395_run_script()
+enum paw3395_script_op {
+    PAW3395_OP_END = 0,
+    PAW3395_OP_WRITE,     // reg <- val, writes to 0x7F switch the bank
+    PAW3395_OP_READ,      // read reg and discard the value
+    PAW3395_OP_DELAY_US,  // wait arg microseconds
+    PAW3395_OP_POLL,      // read reg every 1ms until it equals val, at most arg times;
+                          // on success skip the next `skip` steps
+};
+
+struct paw3395_script_step {
+    uint8_t op;
+    uint8_t reg;
+    uint8_t val;
+    uint8_t skip;
+    uint16_t arg;
+};
+
+// Where a script stopped, so it can be resumed later from a work item
+struct paw3395_script_state {
+    const struct paw3395_script_step *pc;
+    uint16_t polls; // reads done so far by the current POLL step
+};
+
+#define PAW3395_W(r, v) { .op = PAW3395_OP_WRITE, .reg = (r), .val = (v) }
+#define PAW3395_R(r) { .op = PAW3395_OP_READ, .reg = (r) }
+#define PAW3395_DELAY_US(us) { .op = PAW3395_OP_DELAY_US, .arg = (us) }
+#define PAW3395_POLL(r, v, tries, n) \
+    { .op = PAW3395_OP_POLL, .reg = (r), .val = (v), .skip = (n), .arg = (tries) }
+#define PAW3395_END { .op = PAW3395_OP_END }
+
+// Power-up sequence, replaces the old group1/group2 tables
+extern const struct paw3395_script_step paw3395_pwrup_script[];
+
+// Run mode scripts, indexed by enum paw3395_run_mode
+extern const struct paw3395_script_step *const paw3395_mode_scripts[];
 
 #endif // PAW3395_PRIV_H_
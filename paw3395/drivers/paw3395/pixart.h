@@ -11,6 +11,7 @@
 #include <zephyr/drivers/spi.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/sensor.h>
+#include "pixart_spi.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,7 @@ struct pixart_data {
     struct k_work poll_work;
     struct k_timer poll_timer;
     bool sw_smart_flag;
+    struct pixart_spi spi;
 };
 
 struct pixart_config {
@@ -0,0 +1,198 @@
+/*
+ * PixArt sensor SPI transport
+ *
+ * Reads, writes and bursts with NCS held through the whole command, and the
+ * tSRAD / tSWW / tSWR / tSRW gaps enforced from the time the previous
+ * command actually ended rather than padded after every transfer.
+ */
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/spi.h>
+#include "pixart_spi.h"
+
+#ifdef CONFIG_SPI_ASYNC
+// Async bursts are finished here rather than on the system workqueue, where
+// the sensor's own work items may be blocked waiting for this very bus
+#define PIXART_SPI_WORKQ_STACK_SIZE 1024
+#define PIXART_SPI_WORKQ_PRIORITY K_PRIO_COOP(0)
+
+K_THREAD_STACK_DEFINE(pixart_spi_workq_stack, PIXART_SPI_WORKQ_STACK_SIZE);
+static struct k_work_q pixart_spi_workq;
+static bool pixart_spi_workq_started;
+
+static void pixart_spi_async_release(struct k_work *work);
+#endif
+
+void pixart_spi_init(struct pixart_spi *spi, const struct spi_dt_spec *bus,
+                     const struct pixart_spi_timing *timing) {
+    spi->bus = bus;
+    spi->timing = timing;
+    spi->held = bus->config;
+    spi->held.operation |= SPI_HOLD_ON_CS | SPI_LOCK_ON;
+    k_mutex_init(&spi->lock);
+    k_sem_init(&spi->idle, 1, 1);
+#ifdef CONFIG_SPI_ASYNC
+    // Device init runs one driver at a time, so the first caller starts it
+    if (!pixart_spi_workq_started) {
+        k_work_queue_start(&pixart_spi_workq, pixart_spi_workq_stack,
+                           K_THREAD_STACK_SIZEOF(pixart_spi_workq_stack),
+                           PIXART_SPI_WORKQ_PRIORITY, NULL);
+        pixart_spi_workq_started = true;
+    }
+    k_work_init(&spi->async_work, pixart_spi_async_release);
+#endif
+    spi->depth = 0;
+    spi->last_write = false;
+    spi->last_end = k_cycle_get_32();
+}
+
+void pixart_spi_begin(struct pixart_spi *spi) {
+    k_mutex_lock(&spi->lock, K_FOREVER);
+    // The outermost begin also waits for an async burst still on the bus
+    if (spi->depth++ == 0) {
+        k_sem_take(&spi->idle, K_FOREVER);
+    }
+}
+
+void pixart_spi_end(struct pixart_spi *spi) {
+    if (--spi->depth == 0) {
+        spi_release(spi->bus->bus, &spi->held);
+        k_sem_give(&spi->idle);
+    }
+    k_mutex_unlock(&spi->lock);
+}
+
+// Wait out whatever is left of the gap the previous command needs
+static void pixart_spi_gap(struct pixart_spi *spi, bool write) {
+    const struct pixart_spi_timing *t = spi->timing;
+    uint32_t need = spi->last_write ? (write ? t->t_sww : t->t_swr) : t->t_srw;
+    uint32_t spent = k_cyc_to_us_floor32(k_cycle_get_32() - spi->last_end);
+
+    if (spent < need) {
+        k_busy_wait(need - spent);
+    }
+}
+
+static void pixart_spi_done(struct pixart_spi *spi, bool write) {
+    spi->last_write = write;
+    spi->last_end = k_cycle_get_32();
+}
+
+static int pixart_spi_read_cmd(struct pixart_spi *spi, uint8_t reg, uint8_t *buf, size_t len,
+                               uint16_t t_srad) {
+    struct spi_buf tx_buf = {.buf = &reg, .len = 1};
+    struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1};
+    struct spi_buf rx_buf = {.buf = buf, .len = len};
+    struct spi_buf_set rx = {.buffers = &rx_buf, .count = 1};
+    int err;
+
+    pixart_spi_begin(spi);
+    pixart_spi_gap(spi, false);
+    err = spi_write(spi->bus->bus, &spi->held, &tx);
+    if (err == 0) {
+        k_busy_wait(t_srad);
+        err = spi_read(spi->bus->bus, &spi->held, &rx);
+    }
+    pixart_spi_done(spi, false);
+    pixart_spi_end(spi);
+    return err;
+}
+
+int pixart_spi_read(struct pixart_spi *spi, uint8_t reg, uint8_t *val) {
+    return pixart_spi_read_cmd(spi, reg & ~PIXART_SPI_WRITE_BIT, val, 1, spi->timing->t_srad);
+}
+
+int pixart_spi_burst_read(struct pixart_spi *spi, uint8_t reg, uint8_t *buf, size_t len) {
+    return pixart_spi_read_cmd(spi, reg & ~PIXART_SPI_WRITE_BIT, buf, len,
+                               spi->timing->t_srad_burst);
+}
+
+#ifdef CONFIG_SPI_ASYNC
+// Data phase done, back in thread context: the SPI driver is idle again, so
+// NCS can be released and the bus handed back
+static void pixart_spi_async_release(struct k_work *work) {
+    struct pixart_spi *spi = CONTAINER_OF(work, struct pixart_spi, async_work);
+    int result = spi->async_result;
+    int err;
+
+    pixart_spi_done(spi, false);
+    err = spi_release(spi->bus->bus, &spi->held);
+    if (result == 0) {
+        result = err;
+    }
+    k_sem_give(&spi->idle);
+    spi->async_cb(result, spi->async_userdata);
+}
+
+// Data phase done (SPI ISR). The driver is still busy until this returns,
+// so spi_release() would fail here
+static void pixart_spi_async_done(const struct device *dev, int result, void *userdata) {
+    struct pixart_spi *spi = userdata;
+
+    ARG_UNUSED(dev);
+    spi->async_result = result;
+    k_work_submit_to_queue(&pixart_spi_workq, &spi->async_work);
+}
+
+int pixart_spi_burst_read_async(struct pixart_spi *spi, uint8_t reg, uint8_t *buf, size_t len,
+                                pixart_spi_callback_t cb, void *userdata) {
+    uint8_t addr = reg & ~PIXART_SPI_WRITE_BIT;
+    struct spi_buf tx_buf = {.buf = &addr, .len = 1};
+    struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1};
+    int err;
+
+    pixart_spi_begin(spi);
+    if (spi->depth != 1) {
+        // Inside begin()/end() the bus could not be handed to the ISR
+        pixart_spi_end(spi);
+        return -EDEADLK;
+    }
+
+    pixart_spi_gap(spi, false);
+    err = spi_write(spi->bus->bus, &spi->held, &tx);
+    if (err == 0) {
+        k_busy_wait(spi->timing->t_srad_burst);
+        spi->async_rx_buf.buf = buf;
+        spi->async_rx_buf.len = len;
+        spi->async_rx.buffers = &spi->async_rx_buf;
+        spi->async_rx.count = 1;
+        spi->async_cb = cb;
+        spi->async_userdata = userdata;
+        err = spi_transceive_cb(spi->bus->bus, &spi->held, NULL, &spi->async_rx,
+                                pixart_spi_async_done, spi);
+    }
+    if (err) {
+        pixart_spi_done(spi, false);
+        pixart_spi_end(spi);
+        return err;
+    }
+
+    // NCS, the bus and the idle semaphore stay taken until
+    // pixart_spi_async_release(); only the mutex is let go
+    spi->depth = 0;
+    k_mutex_unlock(&spi->lock);
+    return 0;
+}
+#endif
+
+int pixart_spi_write(struct pixart_spi *spi, uint8_t reg, uint8_t val) {
+    const struct pixart_reg_write write = {reg, val};
+    return pixart_spi_write_batch(spi, &write, 1);
+}
+
+int pixart_spi_write_batch(struct pixart_spi *spi, const struct pixart_reg_write *writes,
+                           size_t count) {
+    int err = 0;
+
+    pixart_spi_begin(spi);
+    for (size_t i = 0; i < count && err == 0; ++i) {
+        uint8_t buf[2] = {writes[i].reg | PIXART_SPI_WRITE_BIT, writes[i].val};
+        struct spi_buf tx_buf = {.buf = buf, .len = sizeof(buf)};
+        struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1};
+
+        pixart_spi_gap(spi, true);
+        err = spi_write(spi->bus->bus, &spi->held, &tx);
+        pixart_spi_done(spi, true);
+    }
+    pixart_spi_end(spi);
+    return err;
+}
@@ -0,0 +1,101 @@
+#ifndef ZEPHYR_INCLUDE_PIXART_SPI_H_
+#define ZEPHYR_INCLUDE_PIXART_SPI_H_
+
+/**
+ * @file pixart_spi.h
+ *
+ * @brief SPI register access shared by the PixArt motion sensor drivers
+ *
+ * Every read keeps NCS low from the address byte to the last data byte, and
+ * the gap before each command is only as long as the datasheet asks for:
+ * the time already spent since the previous command counts towards it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/spi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIXART_SPI_WRITE_BIT 0x80
+
+// Inter-command minimums from the sensor datasheet, in microseconds
+struct pixart_spi_timing {
+    uint16_t t_srad;       // read address to first data byte
+    uint16_t t_srad_burst; // burst address to first data byte
+    uint16_t t_sww;        // end of a write to the next write
+    uint16_t t_swr;        // end of a write to the next read
+    uint16_t t_srw;        // end of a read to the next command
+};
+
+struct pixart_reg_write {
+    uint8_t reg;
+    uint8_t val;
+};
+
+// Completion of pixart_spi_burst_read_async(), from the transport's work queue
+typedef void (*pixart_spi_callback_t)(int result, void *userdata);
+
+struct pixart_spi {
+    const struct spi_dt_spec *bus;
+    const struct pixart_spi_timing *timing;
+    struct spi_config held;   // bus config with NCS held and the bus locked
+    struct k_mutex lock;      // recursive, owned between begin() and end()
+    struct k_sem idle;        // taken by the outermost begin(), or by an async burst
+                              // until its data phase completes
+    uint16_t depth;           // nested begin() calls
+    bool last_write;          // whether the previous command was a write
+    uint32_t last_end;        // cycles when the previous command finished
+#ifdef CONFIG_SPI_ASYNC
+    // The SPI driver keeps pointers to these until the burst completes
+    struct spi_buf async_rx_buf;
+    struct spi_buf_set async_rx;
+    pixart_spi_callback_t async_cb;
+    void *async_userdata;
+    struct k_work async_work; // releases the bus once the driver is idle
+    int async_result;
+#endif
+};
+
+void pixart_spi_init(struct pixart_spi *spi, const struct spi_dt_spec *bus,
+                     const struct pixart_spi_timing *timing);
+
+/**
+ * @brief Keep NCS low and the bus to ourselves until pixart_spi_end().
+ *
+ * Commands issued in between go out back to back, separated only by the
+ * datasheet delays. Calls nest.
+ */
+void pixart_spi_begin(struct pixart_spi *spi);
+void pixart_spi_end(struct pixart_spi *spi);
+
+int pixart_spi_read(struct pixart_spi *spi, uint8_t reg, uint8_t *val);
+int pixart_spi_write(struct pixart_spi *spi, uint8_t reg, uint8_t val);
+
+/** @brief Write registers in order in one NCS-low transaction. */
+int pixart_spi_write_batch(struct pixart_spi *spi, const struct pixart_reg_write *writes,
+                           size_t count);
+
+/** @brief Read @p len bytes of a burst register such as motion burst. */
+int pixart_spi_burst_read(struct pixart_spi *spi, uint8_t reg, uint8_t *buf, size_t len);
+
+#ifdef CONFIG_SPI_ASYNC
+/**
+ * @brief Start a burst read and return once its data phase is on the bus.
+ *
+ * The address byte goes out and tSRAD is waited out here, like in
+ * pixart_spi_burst_read(). When the data phase completes, NCS is released
+ * and @p cb called from the transport's work queue; until then every other
+ * command on the transport waits. A failed release is reported through
+ * @p cb. Thread context only, outside begin()/end().
+ */
+int pixart_spi_burst_read_async(struct pixart_spi *spi, uint8_t reg, uint8_t *buf, size_t len,
+                                pixart_spi_callback_t cb, void *userdata);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_PIXART_SPI_H_ */
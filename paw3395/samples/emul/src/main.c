@@ -0,0 +1,116 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/logging/log.h>
+
+#include "paw3395.h"
+#include "paw3395_emul.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
+
+#define SENSOR_NODE DT_NODELABEL(paw3395_0)
+#define THROUGHPUT_READS 10000
+
+static const struct device *sensor = DEVICE_DT_GET(SENSOR_NODE);
+static const struct emul *sensor_emul = EMUL_DT_GET(SENSOR_NODE);
+
+static K_SEM_DEFINE(motion_sem, 0, 1);
+
+static const struct sensor_trigger motion_trigger = {
+    .type = SENSOR_TRIG_DATA_READY,
+    .chan = SENSOR_CHAN_ALL,
+};
+
+// A short flick: accelerate, hold, stop. t_us, dx, dy, squal
+static const struct paw3395_emul_motion flick[] = {
+    {0, 5, -2, 0x40},      {1000, 40, -10, 0x40},   {2000, 300, -80, 0x42},
+    {3000, 1200, -300, 0x42}, {4000, 1200, -300, 0x41}, {5000, 600, -150, 0x40},
+    {6000, 100, -20, 0x3F}, {7000, 3, 0, 0x3F},
+};
+
+static void motion_handler(const struct device *dev, const struct sensor_trigger *trig)
+{
+    k_sem_give(&motion_sem);
+}
+
+static void bench_init_time(void)
+{
+    while (!paw3395_is_ready(sensor))
+    {
+        k_msleep(1);
+    }
+    LOG_INF("Power-up done at %lld ms after boot", k_uptime_get());
+}
+
+static void bench_read_throughput(void)
+{
+    struct paw3395_motion_frame frame;
+    struct paw3395_emul_stats stats;
+
+    paw3395_emul_reset_stats(sensor_emul);
+    uint32_t start = k_cycle_get_32();
+    for (int i = 0; i < THROUGHPUT_READS; ++i)
+    {
+        (void)paw3395_read_motion(sensor, &frame);
+    }
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    paw3395_emul_get_stats(sensor_emul, &stats);
+
+    LOG_INF("%u reads/s (%d reads in %u us, %u bursts on the bus)",
+            (uint32_t)((uint64_t)THROUGHPUT_READS * USEC_PER_SEC / MAX(us, 1)),
+            THROUGHPUT_READS, us, stats.bursts);
+}
+
+static void bench_motion_script(void)
+{
+    struct paw3395_motion_frame frame;
+    int32_t want_x = 0;
+    int32_t want_y = 0;
+    int32_t got_x = 0;
+    int32_t got_y = 0;
+    uint32_t frames = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(flick); ++i)
+    {
+        want_x += flick[i].dx;
+        want_y += flick[i].dy;
+    }
+
+    sensor_trigger_set(sensor, &motion_trigger, motion_handler);
+    paw3395_emul_play(sensor_emul, flick, ARRAY_SIZE(flick));
+
+    // Same loop shape as the mouse: wake on the pin, read until still
+    while (paw3395_emul_is_playing(sensor_emul) || k_sem_count_get(&motion_sem) > 0)
+    {
+        if (k_sem_take(&motion_sem, K_MSEC(10)) != 0)
+        {
+            continue;
+        }
+        while (paw3395_read_motion(sensor, &frame) == 0)
+        {
+            got_x += frame.dx;
+            got_y += frame.dy;
+            frames++;
+        }
+    }
+
+    LOG_INF("Script: injected (%d, %d), read (%d, %d) in %u frames: %s",
+            want_x, want_y, got_x, got_y, frames,
+            (want_x == got_x && want_y == got_y) ? "exact" : "MISMATCH");
+}
+
+int main(void)
+{
+    if (!device_is_ready(sensor))
+    {
+        LOG_ERR("PAW3395 device not ready");
+        return 0;
+    }
+
+    bench_init_time();
+    bench_read_throughput();
+    bench_motion_script();
+
+    return 0;
+}
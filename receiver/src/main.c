@@ -0,0 +1,193 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/usb/usb_device.h>
+#include <zephyr/usb/class/usb_hid.h>
+#include <zephyr/logging/log.h>
+
+#include "esb_link.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
+
+#define REPORT_SIZE 4
+
+// esb_link_report button bits that USB carries in the other order
+#define LINK_BTN_BACK BIT(3)
+#define LINK_BTN_FORWARD BIT(4)
+
+static const uint8_t hid_report_desc[] = HID_MOUSE_REPORT_DESC(5);
+static const struct device *hid_dev;
+static K_SEM_DEFINE(ep_write_sem, 0, 1);
+// New motion from the mouse or a USB state change
+static K_SEM_DEFINE(wake_sem, 0, 1);
+
+static struct esb_link link;
+static atomic_t usb_configured;
+// Suspend keeps the configuration, resume makes it usable again
+static atomic_t usb_suspended;
+
+// Reports integrated in 32 bits between USB frames
+static struct k_spinlock pending_lock;
+static int32_t pending_x;
+static int32_t pending_y;
+static int32_t pending_wheel;
+static uint8_t pending_buttons;
+static bool buttons_dirty;
+
+static void status_cb(enum usb_dc_status_code status, const uint8_t *param)
+{
+    switch (status)
+    {
+    case USB_DC_CONFIGURED:
+        atomic_set(&usb_configured, 1);
+        k_sem_give(&wake_sem);
+        break;
+    case USB_DC_SUSPEND:
+        atomic_set(&usb_suspended, 1);
+        k_sem_give(&wake_sem);
+        break;
+    case USB_DC_RESUME:
+        atomic_clear(&usb_suspended);
+        k_sem_give(&wake_sem);
+        break;
+    case USB_DC_DISCONNECTED:
+    case USB_DC_RESET:
+    case USB_DC_ERROR:
+        atomic_clear(&usb_configured);
+        atomic_clear(&usb_suspended);
+        k_sem_give(&wake_sem);
+        break;
+    default:
+        break;
+    }
+}
+
+// Configured and not suspended: reports sent now reach the host
+static bool usb_ready(void)
+{
+    return atomic_get(&usb_configured) && !atomic_get(&usb_suspended);
+}
+
+static void int_in_ready_cb(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+    k_sem_give(&ep_write_sem);
+}
+
+static const struct hid_ops ops = {
+    .int_in_ready = int_in_ready_cb,
+};
+
+// Radio ISR context
+static void link_report(struct esb_link *l, const struct esb_link_report *report)
+{
+    ARG_UNUSED(l);
+
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+    pending_x += report->x;
+    pending_y += report->y;
+    pending_wheel += report->wheel;
+    if (report->buttons != pending_buttons)
+    {
+        pending_buttons = report->buttons;
+        buttons_dirty = true;
+    }
+    k_spin_unlock(&pending_lock, key);
+
+    k_sem_give(&wake_sem);
+}
+
+static void link_state(struct esb_link *l, bool up)
+{
+    ARG_UNUSED(l);
+    LOG_INF("Mouse %s", up ? "connected" : "lost");
+}
+
+static const struct esb_link_callbacks link_cb = {
+    .report = link_report,
+    .link_state = link_state,
+};
+
+// Take what fits in one 8-bit report, the rest stays for the next frame
+static bool take_report(uint8_t *report)
+{
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+    int8_t dx = CLAMP(pending_x, INT8_MIN, INT8_MAX);
+    int8_t dy = CLAMP(pending_y, INT8_MIN, INT8_MAX);
+    int8_t wheel = CLAMP(pending_wheel, INT8_MIN, INT8_MAX);
+    bool send = dx != 0 || dy != 0 || wheel != 0 || buttons_dirty;
+
+    pending_x -= dx;
+    pending_y -= dy;
+    pending_wheel -= wheel;
+    buttons_dirty = false;
+
+    // Same bit order as the mouse's own USB report: forward is button 4
+    // and back button 5, swapped from the link's
+    report[0] = (pending_buttons & (BIT(0) | BIT(1) | BIT(2))) |
+                ((pending_buttons & LINK_BTN_FORWARD) ? BIT(3) : 0) |
+                ((pending_buttons & LINK_BTN_BACK) ? BIT(4) : 0);
+    report[1] = dx;
+    report[2] = dy;
+    report[3] = wheel;
+    k_spin_unlock(&pending_lock, key);
+
+    return send;
+}
+
+static void update_ack_payload(void)
+{
+    static int8_t sent = -1;
+    uint8_t ack = usb_ready() ? ESB_LINK_ACK_HOST_READY : 0;
+
+    if (ack != sent && esb_link_set_ack_payload(&link, &ack, sizeof(ack)) == 0)
+    {
+        sent = ack;
+    }
+}
+
+int main(void)
+{
+    uint8_t report[REPORT_SIZE];
+    int err;
+
+    hid_dev = device_get_binding("HID_0");
+    if (!hid_dev)
+    {
+        LOG_ERR("Failed to get HID device");
+        return 0;
+    }
+
+    usb_hid_register_device(hid_dev, hid_report_desc, sizeof(hid_report_desc), &ops);
+    usb_hid_init(hid_dev);
+
+    err = usb_enable(status_cb);
+    if (err)
+    {
+        LOG_ERR("USB enable failed: %d", err);
+        return 0;
+    }
+
+    err = esb_link_init(&link, esb_radio_nrf_get(), ESB_RADIO_PRX, &link_cb, NULL);
+    if (err)
+    {
+        LOG_ERR("ESB link init failed: %d", err);
+        return 0;
+    }
+
+    while (1)
+    {
+        k_sem_take(&wake_sem, K_FOREVER);
+        update_ack_payload();
+
+        // Drain into consecutive frames; the IN endpoint paces the loop
+        while (usb_ready() && take_report(report))
+        {
+            if (hid_int_ep_write(hid_dev, report, REPORT_SIZE, NULL) == 0)
+            {
+                k_sem_take(&ep_write_sem, K_MSEC(100));
+            }
+        }
+    }
+
+    return 0;
+}